@@ -0,0 +1,88 @@
+/*
+Copyright (c) 2026
+        pianobar contributors
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/* Compare building a list by appending with PianoListAppend, which walks to
+ * the end every time, and with PianoListAppendTail.
+ *
+ *	usage: append [elements] [rounds]
+ */
+
+#include "bench.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <piano.h>
+
+/*	build a list of preallocated elements, return time spent in
+ *	nanoseconds
+ */
+static unsigned long long run(PianoListHead_t *const elements,
+                              const unsigned int n, const bool tail) {
+    PianoListHead_t *l = NULL, *last = NULL;
+
+    for (unsigned int i = 0; i < n; i++) {
+        elements[i].next = NULL;
+    }
+
+    const unsigned long long start = BenchNowNs();
+    for (unsigned int i = 0; i < n; i++) {
+        if (tail) {
+            l = PianoListAppendTail(l, &last, &elements[i]);
+        } else {
+            l = PianoListAppend(l, &elements[i]);
+        }
+    }
+    const unsigned long long end = BenchNowNs();
+
+    if (PianoListCount(l) != n) {
+        fprintf(stderr, "append failed\n");
+        exit(EXIT_FAILURE);
+    }
+    return end - start;
+}
+
+int main(int argc, char **argv) {
+    const unsigned int n = argc > 1 ? atoi(argv[1]) : 1000;
+    const unsigned int rounds = argc > 2 ? atoi(argv[2]) : 100;
+    PianoListHead_t *const elements = calloc(n, sizeof(*elements));
+    if (n == 0 || rounds == 0 || elements == NULL) {
+        return EXIT_FAILURE;
+    }
+
+    printf("%u elements, %u rounds\n", n, rounds);
+    printf("%-10s %10s %10s\n", "", "time/ns", "ns/append");
+
+    static const char *const names[] = {"walk", "tail"};
+    for (int tail = 0; tail < 2; tail++) {
+        unsigned long long best = ~0ULL;
+        for (unsigned int i = 0; i < rounds; i++) {
+            const unsigned long long t = run(elements, n, tail);
+            best = t < best ? t : best;
+        }
+        printf("%-10s %10llu %10llu\n", names[tail], best, best / n);
+    }
+
+    free(elements);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,145 @@
+/*
+Copyright (c) 2026
+        pianobar contributors
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/* allocation counting and timing shared by the benchmarks */
+
+#include "bench.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+BenchAlloc_t benchAlloc;
+
+#ifdef __GLIBC__
+
+#include <errno.h>
+#include <malloc.h>
+
+const bool benchAllocCounted = true;
+
+extern void *__libc_malloc(size_t);
+extern void *__libc_calloc(size_t, size_t);
+extern void *__libc_realloc(void *, size_t);
+extern void *__libc_memalign(size_t, size_t);
+extern void __libc_free(void *);
+
+/*	count a new block
+ */
+static void *added(void *const p) {
+    if (p != NULL) {
+        ++benchAlloc.allocs;
+        ++benchAlloc.blocks;
+        benchAlloc.live += malloc_usable_size(p);
+        if (benchAlloc.live > benchAlloc.peak) {
+            benchAlloc.peak = benchAlloc.live;
+        }
+    }
+    return p;
+}
+
+void *malloc(size_t size) {
+    return added(__libc_malloc(size));
+}
+
+void *calloc(size_t nmemb, size_t size) {
+    return added(__libc_calloc(nmemb, size));
+}
+
+void *realloc(void *ptr, size_t size) {
+    const size_t old = ptr == NULL ? 0 : malloc_usable_size(ptr);
+    void *const p = __libc_realloc(ptr, size);
+    if (ptr != NULL && (p != NULL || size == 0)) {
+        /* the old block is gone */
+        --benchAlloc.blocks;
+        benchAlloc.live -= old;
+    }
+    return added(p);
+}
+
+void *memalign(size_t alignment, size_t size) {
+    return added(__libc_memalign(alignment, size));
+}
+
+void *aligned_alloc(size_t alignment, size_t size) {
+    return added(__libc_memalign(alignment, size));
+}
+
+int posix_memalign(void **memptr, size_t alignment, size_t size) {
+    void *const p = added(__libc_memalign(alignment, size));
+    if (p == NULL) {
+        return ENOMEM;
+    }
+    *memptr = p;
+    return 0;
+}
+
+void free(void *ptr) {
+    if (ptr != NULL) {
+        --benchAlloc.blocks;
+        benchAlloc.live -= malloc_usable_size(ptr);
+        __libc_free(ptr);
+    }
+}
+
+#else
+
+/* no portable way to replace malloc, only timings are reported */
+const bool benchAllocCounted = false;
+
+#endif
+
+/*	start counting, blocks allocated before are not included
+ */
+void BenchAllocReset(void) {
+    benchAlloc.allocs = 0;
+    benchAlloc.blocks = 0;
+    benchAlloc.live = 0;
+    benchAlloc.peak = 0;
+}
+
+/*	format heap usage for printing
+ *	@return buf, or "n/a" if allocations are not counted
+ */
+const char *BenchHeapFormat(char *const buf, const size_t size,
+                            const long long v) {
+    if (!benchAllocCounted) {
+        return "n/a";
+    }
+    snprintf(buf, size, "%lld", v);
+    return buf;
+}
+
+/*	monotonic clock, nanoseconds
+ */
+unsigned long long BenchNowNs(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long long)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+/*	monotonic clock, microseconds
+ */
+unsigned long long BenchNowUs(void) {
+    return BenchNowNs() / 1000;
+}
@@ -0,0 +1,50 @@
+/*
+Copyright (c) 2026
+        pianobar contributors
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#pragma once
+
+/* glibc feature test macros, define _before_ including other files */
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/* heap usage since the last BenchAllocReset, counted by replacing malloc
+ * and friends (glibc only, see benchAllocCounted) */
+typedef struct {
+    /* successful malloc, calloc and realloc calls */
+    unsigned long allocs;
+    /* blocks in use, relative to the last reset */
+    long blocks;
+    /* bytes in use and their maximum, relative to the last reset */
+    long long live, peak;
+} BenchAlloc_t;
+
+extern BenchAlloc_t benchAlloc;
+/* false if the C library does not allow counting, benchAlloc stays zero */
+extern const bool benchAllocCounted;
+
+void BenchAllocReset(void);
+const char *BenchHeapFormat(char *, size_t, long long);
+unsigned long long BenchNowNs(void);
+unsigned long long BenchNowUs(void);
@@ -0,0 +1,216 @@
+/*
+Copyright (c) 2026
+        pianobar contributors
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/* Replay login, station list and playlist calls against contrib/mockpandora.py
+ * and report calls per second and latency percentiles. Exits with failure if
+ * any call fails, so it can run in CI.
+ *
+ *	usage: mock ca_bundle [rounds] [host] [port] [tls_port]
+ *
+ * The defaults match mockpandora.py, start it with --cert and --key first.
+ */
+
+#include "bench.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <curl/curl.h>
+#include <piano.h>
+
+typedef enum {
+    CALL_LOGIN = 0,
+    CALL_STATIONS,
+    CALL_PLAYLIST,
+    CALL_COUNT,
+} Call_t;
+
+static const char *const names[] = {"login", "stations", "playlist"};
+
+typedef struct {
+    CURL *http;
+    const char *host, *port, *tlsPort;
+    /* latency of every call, microseconds */
+    unsigned long long *latency[CALL_COUNT];
+    unsigned long long spent[CALL_COUNT];
+    unsigned int calls[CALL_COUNT];
+} Mock_t;
+
+static size_t fetchCb(char *ptr, size_t size, size_t nmemb, void *userdata) {
+    PianoRequest_t *const req = userdata;
+    const size_t recvSize = size * nmemb;
+
+    PianoResponseFeed(req, ptr, recvSize);
+
+    return recvSize;
+}
+
+/*	run all steps of one request, like BarRpc does, and record its latency
+ */
+static void call(Mock_t *const m, PianoHandle_t *const ph, const Call_t which,
+                 const PianoRequestType_t type, void *const data) {
+    PianoReturn_t pRet;
+    CURLcode wRet = CURLE_OK;
+
+    const unsigned long long start = BenchNowUs();
+    do {
+        PianoRequest_t req;
+        memset(&req, 0, sizeof(req));
+        req.data = data;
+        if ((pRet = PianoRequest(ph, &req, type)) != PIANO_RET_OK) {
+            PianoDestroyRequest(&req);
+            break;
+        }
+
+        char url[2048];
+        snprintf(url, sizeof(url), "%s://%s:%s%s",
+                 req.secure ? "https" : "http", m->host,
+                 req.secure ? m->tlsPort : m->port, req.urlPath);
+        curl_easy_setopt(m->http, CURLOPT_URL, url);
+        curl_easy_setopt(m->http, CURLOPT_POSTFIELDS, req.postData);
+        curl_easy_setopt(m->http, CURLOPT_WRITEDATA, &req);
+
+        if ((wRet = curl_easy_perform(m->http)) == CURLE_OK) {
+            pRet = PianoResponse(ph, &req);
+        }
+        PianoDestroyRequest(&req);
+    } while (wRet == CURLE_OK && pRet == PIANO_RET_CONTINUE_REQUEST);
+    const unsigned long long end = BenchNowUs();
+
+    if (wRet != CURLE_OK) {
+        fprintf(stderr, "%s failed: %s\n", names[which],
+                curl_easy_strerror(wRet));
+        exit(EXIT_FAILURE);
+    } else if (pRet != PIANO_RET_OK) {
+        fprintf(stderr, "%s failed: %s\n", names[which],
+                PianoErrorToStr(pRet));
+        exit(EXIT_FAILURE);
+    }
+
+    m->latency[which][m->calls[which]++] = end - start;
+    m->spent[which] += end - start;
+}
+
+static int compare(const void *a, const void *b) {
+    const unsigned long long x = *(const unsigned long long *)a,
+                             y = *(const unsigned long long *)b;
+    return x < y ? -1 : x > y;
+}
+
+/*	percentile of sorted values, same as mockpandora.py
+ */
+static unsigned long long percentile(const unsigned long long *const values,
+                                     const unsigned int n,
+                                     const unsigned int p) {
+    const unsigned int i = n * p / 100;
+    return values[i < n ? i : n - 1];
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s ca_bundle [rounds] [host] [port] "
+                        "[tls_port]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    const unsigned int rounds = argc > 2 ? atoi(argv[2]) : 100;
+    Mock_t m = {
+        .host = argc > 3 ? argv[3] : "127.0.0.1",
+        .port = argc > 4 ? argv[4] : "8080",
+        .tlsPort = argc > 5 ? argv[5] : "8443",
+    };
+    if (rounds == 0) {
+        return EXIT_FAILURE;
+    }
+    for (size_t i = 0; i < CALL_COUNT; i++) {
+        if ((m.latency[i] = calloc(rounds, sizeof(*m.latency[i]))) == NULL) {
+            return EXIT_FAILURE;
+        }
+    }
+
+    curl_global_init(CURL_GLOBAL_DEFAULT);
+    struct curl_slist *const headers =
+        curl_slist_append(NULL, "Content-Type: text/plain");
+    /* one handle, the connections are kept alive like BarRpc's */
+    if (headers == NULL || (m.http = curl_easy_init()) == NULL) {
+        return EXIT_FAILURE;
+    }
+    curl_easy_setopt(m.http, CURLOPT_WRITEFUNCTION, fetchCb);
+    curl_easy_setopt(m.http, CURLOPT_POST, 1L);
+    curl_easy_setopt(m.http, CURLOPT_HTTPHEADER, headers);
+    curl_easy_setopt(m.http, CURLOPT_CAINFO, argv[1]);
+
+    /* same as pianobar's defaults */
+    PianoHandle_t ph;
+    if (PianoInit(&ph, "android", "AC7IBG09A3DTSYM4R41UJWL07VLN8JI7",
+                  "android-generic", "R=U!LH$O2B#", "6#26FRL$ZWD") !=
+        PIANO_RET_OK) {
+        return EXIT_FAILURE;
+    }
+
+    const unsigned long long start = BenchNowUs();
+    for (unsigned int i = 0; i < rounds; i++) {
+        PianoRequestDataLogin_t login = {
+            .user = "user@example.com",
+            .password = "secret",
+        };
+        call(&m, &ph, CALL_LOGIN, PIANO_REQUEST_LOGIN, &login);
+
+        call(&m, &ph, CALL_STATIONS, PIANO_REQUEST_GET_STATIONS, NULL);
+        if (ph.stations == NULL) {
+            fprintf(stderr, "no stations\n");
+            return EXIT_FAILURE;
+        }
+
+        PianoRequestDataGetPlaylist_t playlist = {
+            .station = ph.stations,
+            .quality = PIANO_AQ_HIGH,
+        };
+        call(&m, &ph, CALL_PLAYLIST, PIANO_REQUEST_GET_PLAYLIST, &playlist);
+        PianoDestroyPlaylist(playlist.retPlaylist);
+    }
+    const unsigned long long end = BenchNowUs();
+
+    printf("%u rounds against %s, ports %s and %s\n", rounds, m.host, m.port,
+           m.tlsPort);
+    printf("%-10s %10s %10s %10s %10s\n", "", "calls/s", "p50/us", "p90/us",
+           "p99/us");
+    for (size_t i = 0; i < CALL_COUNT; i++) {
+        unsigned long long *const values = m.latency[i];
+        qsort(values, m.calls[i], sizeof(*values), compare);
+        printf("%-10s %10.1f %10llu %10llu %10llu\n", names[i],
+               m.calls[i] * 1e6 / (m.spent[i] ? m.spent[i] : 1),
+               percentile(values, m.calls[i], 50),
+               percentile(values, m.calls[i], 90),
+               percentile(values, m.calls[i], 99));
+        free(values);
+    }
+    printf("%-10s %10.1f\n", "total",
+           rounds * (double)CALL_COUNT * 1e6 / (end - start ? end - start : 1));
+
+    PianoDestroy(&ph);
+    curl_easy_cleanup(m.http);
+    curl_slist_free_all(headers);
+    curl_global_cleanup();
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,153 @@
+/*
+Copyright (c) 2026
+        pianobar contributors
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/* Compare parsing a station list after the whole response was buffered with
+ * feeding it to the parser chunk by chunk while it is received.
+ *
+ *	usage: parse [stations] [rounds]
+ */
+
+#include "bench.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <piano.h>
+
+/* largest chunk curl hands to the write callback by default */
+#define CHUNK 16384
+
+/*	station list response as sent by the api, including the keys libpiano
+ *	does not read
+ */
+static char *makeResponse(const unsigned int stations, size_t *const len) {
+    size_t size = 256 + stations * 512;
+    char *const buf = malloc(size);
+    if (buf == NULL) {
+        return NULL;
+    }
+
+    size_t pos = snprintf(buf, size, "{\"stat\":\"ok\",\"result\":{"
+                                     "\"checksum\":\"0123456789abcdef\","
+                                     "\"stations\":[");
+    for (unsigned int i = 0; i < stations; i++) {
+        pos += snprintf(
+            &buf[pos], size - pos,
+            "%s{\"stationToken\":\"%u\",\"stationId\":\"%u\","
+            "\"stationName\":\"Station number %u Radio\","
+            "\"isShared\":false,\"isQuickMix\":false,\"allowRename\":true,"
+            "\"allowDelete\":true,\"allowAddMusic\":true,"
+            "\"requiresCleanAds\":false,\"dateCreated\":{\"time\":%u},"
+            "\"genre\":[\"Rock\",\"Pop\"],\"stationDetailUrl\":"
+            "\"https://www.pandora.com/login?target=/stations/%u\","
+            "\"artUrl\":\"https://content-images.p-cdn.com/images/%u.jpg\"}",
+            i == 0 ? "" : ",", 4000000 + i, 4000000 + i, i, 1400000000 + i,
+            i, i);
+    }
+    pos += snprintf(&buf[pos], size - pos, "]}}");
+    *len = pos;
+    return buf;
+}
+
+/*	what the curl write callback did before responses were parsed
+ *	incrementally: append the chunk to a NUL-terminated buffer
+ */
+static void bufferChunk(PianoRequest_t *const req, size_t *const size,
+                        const char *const data, const size_t len) {
+    char *const buf = realloc(req->responseData, *size + len + 1);
+    if (buf == NULL) {
+        abort();
+    }
+    memcpy(&buf[*size], data, len);
+    *size += len;
+    buf[*size] = '\0';
+    req->responseData = buf;
+}
+
+/*	receive and parse the response once, return time spent in microseconds
+ */
+static unsigned long long run(const char *const response, const size_t len,
+                              const bool feed) {
+    PianoHandle_t ph;
+    memset(&ph, 0, sizeof(ph));
+    PianoRequest_t req;
+    memset(&req, 0, sizeof(req));
+    req.type = PIANO_REQUEST_GET_STATIONS;
+    size_t buffered = 0;
+
+    const unsigned long long start = BenchNowUs();
+    for (size_t pos = 0; pos < len; pos += CHUNK) {
+        const size_t n = len - pos < CHUNK ? len - pos : CHUNK;
+        if (feed) {
+            PianoResponseFeed(&req, &response[pos], n);
+        } else {
+            bufferChunk(&req, &buffered, &response[pos], n);
+        }
+    }
+    const PianoReturn_t ret = PianoResponse(&ph, &req);
+    free(req.responseData);
+    PianoDestroyRequest(&req);
+    const unsigned long long end = BenchNowUs();
+
+    if (ret != PIANO_RET_OK || ph.stations == NULL) {
+        fprintf(stderr, "parsing failed: %s\n", PianoErrorToStr(ret));
+        exit(EXIT_FAILURE);
+    }
+    PianoDestroy(&ph);
+
+    return end - start;
+}
+
+int main(int argc, char **argv) {
+    const unsigned int stations = argc > 1 ? atoi(argv[1]) : 5000;
+    const unsigned int rounds = argc > 2 ? atoi(argv[2]) : 20;
+
+    size_t len;
+    char *const response = makeResponse(stations, &len);
+    if (response == NULL || stations == 0 || rounds == 0) {
+        return EXIT_FAILURE;
+    }
+    printf("%u stations, %zu KiB response, %d KiB chunks, %u rounds\n",
+           stations, len / 1024, CHUNK / 1024, rounds);
+    printf("%-10s %10s %12s %10s\n", "", "time/us", "peak/KiB", "allocs");
+
+    static const char *const names[] = {"buffered", "feed"};
+    for (int feed = 0; feed < 2; feed++) {
+        unsigned long long best = ~0ULL;
+        for (unsigned int i = 0; i < rounds; i++) {
+            const unsigned long long t = run(response, len, feed);
+            best = t < best ? t : best;
+        }
+        /* heap usage does not vary between rounds */
+        BenchAllocReset();
+        run(response, len, feed);
+        char peak[32], allocs[32];
+        printf("%-10s %10llu %12s %10s\n", names[feed], best,
+               BenchHeapFormat(peak, sizeof(peak), benchAlloc.peak / 1024),
+               BenchHeapFormat(allocs, sizeof(allocs), benchAlloc.allocs));
+    }
+
+    free(response);
+    return EXIT_SUCCESS;
+}
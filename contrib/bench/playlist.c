@@ -0,0 +1,194 @@
+/*
+Copyright (c) 2026
+        pianobar contributors
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/* Heap usage of playlists allocated from an arena, compared with the same
+ * songs copied into individually allocated records, as they were before.
+ *
+ *	usage: playlist [songs] [rounds]
+ *
+ * With glibc, freeing the arena's chunks next to the memory just released by
+ * the json parser consolidates the fast bins, which dominates the time to
+ * free it. GLIBC_TUNABLES=glibc.malloc.mxfast=0 leaves that out.
+ */
+
+#include "bench.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <piano.h>
+
+/*	playlist response with some songs
+ */
+static char *makeResponse(const unsigned int songs) {
+    const size_t size = 64 + songs * 1024;
+    char *const buf = malloc(size);
+    if (buf == NULL) {
+        return NULL;
+    }
+
+    size_t pos =
+        snprintf(buf, size, "{\"stat\":\"ok\",\"result\":{\"items\":[");
+    for (unsigned int i = 0; i < songs; i++) {
+        pos += snprintf(
+            &buf[pos], size - pos,
+            "%s{\"artistName\":\"Artist %u\",\"albumName\":\"Album %u\","
+            "\"songName\":\"Song number %u\",\"trackToken\":"
+            "\"a1b2c3d4e5f60718293a4b5c6d7e8f90a1b2c3d4e5f6%u\","
+            "\"stationId\":\"4000000\",\"albumArtUrl\":"
+            "\"https://content-images.p-cdn.com/images/%u_500W_500H.jpg\","
+            "\"songDetailUrl\":\"https://www.pandora.com/artist/%u\","
+            "\"trackGain\":\"1.23\",\"trackLength\":%u,\"songRating\":0,"
+            "\"audioUrlMap\":{\"highQuality\":{\"encoding\":\"aacplus\","
+            "\"bitrate\":\"64\",\"audioUrl\":"
+            "\"http://audio-dc6-t3-1.pandora.com/access/%u.mp4?version=5\"}}}",
+            i == 0 ? "" : ",", i % 3, i % 3, i, i, i, i, 180 + i, i);
+    }
+    snprintf(&buf[pos], size - pos, "]}}");
+    return buf;
+}
+
+static char *copyString(const char *const s) {
+    char *const c = s == NULL ? NULL : strdup(s);
+    if (s != NULL && c == NULL) {
+        abort();
+    }
+    return c;
+}
+
+/*	copy songs into separately allocated records
+ */
+static PianoSong_t *copyPlaylist(const PianoSong_t *src) {
+    PianoSong_t *playlist = NULL;
+    PianoListHead_t *tail = NULL;
+
+    PianoListForeachP(src) {
+        PianoSong_t *const s = calloc(1, sizeof(*s));
+        if (s == NULL) {
+            abort();
+        }
+        s->audioUrl = copyString(src->audioUrl);
+        s->coverArt = copyString(src->coverArt);
+        s->artist = copyString(src->artist);
+        s->musicId = copyString(src->musicId);
+        s->title = copyString(src->title);
+        s->stationId = copyString(src->stationId);
+        s->album = copyString(src->album);
+        s->feedbackId = copyString(src->feedbackId);
+        s->seedId = copyString(src->seedId);
+        s->detailUrl = copyString(src->detailUrl);
+        s->trackToken = copyString(src->trackToken);
+        s->fileGain = src->fileGain;
+        s->length = src->length;
+        s->audioFormat = src->audioFormat;
+        playlist = PianoListAppendTailP(playlist, &tail, s);
+    }
+    return playlist;
+}
+
+static PianoSong_t *parse(PianoHandle_t *const ph, const char *const response) {
+    PianoRequestDataGetPlaylist_t reqData;
+    memset(&reqData, 0, sizeof(reqData));
+    reqData.quality = PIANO_AQ_HIGH;
+    PianoRequest_t req;
+    memset(&req, 0, sizeof(req));
+    req.type = PIANO_REQUEST_GET_PLAYLIST;
+    req.data = &reqData;
+
+    PianoResponseFeed(&req, response, strlen(response));
+    const PianoReturn_t ret = PianoResponse(ph, &req);
+    PianoDestroyRequest(&req);
+    if (ret != PIANO_RET_OK || reqData.retPlaylist == NULL) {
+        fprintf(stderr, "parsing failed: %s\n", PianoErrorToStr(ret));
+        exit(EXIT_FAILURE);
+    }
+    return reqData.retPlaylist;
+}
+
+/*	keep the playlist's heap usage and free it, return time spent in
+ *	nanoseconds
+ */
+static unsigned long long destroy(PianoSong_t *const playlist,
+                                  long *const blocks, long long *const bytes) {
+    *blocks = benchAlloc.blocks;
+    *bytes = benchAlloc.live;
+    const unsigned long long start = BenchNowNs();
+    PianoDestroyPlaylist(playlist);
+    return BenchNowNs() - start;
+}
+
+int main(int argc, char **argv) {
+    const unsigned int songs = argc > 1 ? atoi(argv[1]) : 4;
+    const unsigned int rounds = argc > 2 ? atoi(argv[2]) : 1000;
+    char *const response = songs == 0 ? NULL : makeResponse(songs);
+    if (response == NULL || rounds == 0) {
+        return EXIT_FAILURE;
+    }
+
+    PianoHandle_t ph;
+    memset(&ph, 0, sizeof(ph));
+
+    /* the whole response, including the json objects */
+    BenchAllocReset();
+    const unsigned long long start = BenchNowUs();
+    for (unsigned int i = 0; i < rounds; i++) {
+        PianoDestroyPlaylist(parse(&ph, response));
+    }
+    const unsigned long long end = BenchNowUs();
+    printf("%u songs, %zu byte response\n", songs, strlen(response));
+    char allocs[32], peak[32];
+    printf("parse: %llu us, %s allocations, %s bytes peak per response\n",
+           (end - start) / rounds,
+           BenchHeapFormat(allocs, sizeof(allocs), benchAlloc.allocs / rounds),
+           BenchHeapFormat(peak, sizeof(peak), benchAlloc.peak));
+
+    /* what remains once the response is parsed */
+    printf("%-10s %10s %10s %10s\n", "records", "blocks", "bytes", "free/ns");
+    long blocks;
+    long long bytes;
+    char blocksStr[32], bytesStr[32];
+    unsigned long long t = 0;
+    for (unsigned int i = 0; i < rounds; i++) {
+        BenchAllocReset();
+        t += destroy(parse(&ph, response), &blocks, &bytes);
+    }
+    printf("%-10s %10s %10s %10llu\n", "arena",
+           BenchHeapFormat(blocksStr, sizeof(blocksStr), blocks),
+           BenchHeapFormat(bytesStr, sizeof(bytesStr), bytes), t / rounds);
+
+    PianoSong_t *const playlist = parse(&ph, response);
+    t = 0;
+    for (unsigned int i = 0; i < rounds; i++) {
+        BenchAllocReset();
+        t += destroy(copyPlaylist(playlist), &blocks, &bytes);
+    }
+    printf("%-10s %10s %10s %10llu\n", "separate",
+           BenchHeapFormat(blocksStr, sizeof(blocksStr), blocks),
+           BenchHeapFormat(bytesStr, sizeof(bytesStr), bytes), t / rounds);
+    PianoDestroyPlaylist(playlist);
+
+    PianoDestroy(&ph);
+    free(response);
+    return EXIT_SUCCESS;
+}
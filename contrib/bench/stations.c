@@ -0,0 +1,99 @@
+/*
+Copyright (c) 2026
+        pianobar contributors
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/* Compare looking up stations by id with a linear scan of the station list
+ * and with the hash index.
+ *
+ *	usage: stations [stations] [lookups]
+ */
+
+#include "bench.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <piano.h>
+
+/*	look up pseudo-random existing ids, return time spent in microseconds
+ */
+static unsigned long long run(const PianoHandle_t *const ph,
+                              char (*const ids)[16],
+                              const unsigned int stations,
+                              const unsigned int lookups) {
+    unsigned int found = 0, r = 1;
+
+    const unsigned long long start = BenchNowUs();
+    for (unsigned int i = 0; i < lookups; i++) {
+        r = r * 1103515245 + 12345;
+        found += PianoFindStationById(ph, ids[r % stations]) != NULL;
+    }
+    const unsigned long long end = BenchNowUs();
+
+    if (found != lookups) {
+        fprintf(stderr, "lookup failed\n");
+        exit(EXIT_FAILURE);
+    }
+    return end - start;
+}
+
+int main(int argc, char **argv) {
+    const unsigned int stations = argc > 1 ? atoi(argv[1]) : 100;
+    const unsigned int lookups = argc > 2 ? atoi(argv[2]) : 1000000;
+    if (stations == 0 || lookups == 0) {
+        return EXIT_FAILURE;
+    }
+
+    PianoHandle_t ph;
+    memset(&ph, 0, sizeof(ph));
+    char (*const ids)[16] = calloc(stations, sizeof(*ids));
+    PianoListHead_t *tail = NULL;
+    for (unsigned int i = 0; i < stations && ids != NULL; i++) {
+        PianoStation_t *const s = calloc(1, sizeof(*s));
+        snprintf(ids[i], sizeof(*ids), "%u", 4000000 + i * 7919);
+        if (s == NULL || (s->id = strdup(ids[i])) == NULL ||
+            (s->name = strdup(ids[i])) == NULL) {
+            return EXIT_FAILURE;
+        }
+        ph.stations = PianoListAppendTailP(ph.stations, &tail, s);
+    }
+    if (ids == NULL) {
+        return EXIT_FAILURE;
+    }
+    printf("%u stations, %u lookups\n", stations, lookups);
+    printf("%-10s %10s %10s\n", "", "time/us", "ns/lookup");
+
+    /* without an index the list is scanned */
+    const unsigned long long linear = run(&ph, ids, stations, lookups);
+    printf("%-10s %10llu %10llu\n", "linear", linear,
+           linear * 1000 / lookups);
+
+    PianoIndexStations(&ph);
+    const unsigned long long indexed = run(&ph, ids, stations, lookups);
+    printf("%-10s %10llu %10llu\n", "indexed", indexed,
+           indexed * 1000 / lookups);
+
+    PianoDestroy(&ph);
+    free(ids);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,342 @@
+#!/usr/bin/env python3
+##
+## Local stand-in for Pandora's JSON API, for working on pianobar and libpiano
+## without the live service. Answers auth.partnerLogin, auth.userLogin,
+## user.getStationList, station.getPlaylist and the simple calls with fixtures,
+## optionally with added latency and errors, and reports how fast it was hit.
+##
+## Request bodies and the partner login time are encrypted with Blowfish, using
+## libgcrypt like src/libpiano/crypt.c does.
+##
+## pianobar talks plain http on rpc_port and https on rpc_tls_port, so run this
+## with a certificate for the https port and a config like
+##
+##   rpc_host = 127.0.0.1
+##   rpc_port = 8080
+##   rpc_tls_port = 8443
+##   ca_bundle = /path/to/cert.pem
+##   user = user@example.com
+##   password = secret
+##
+## Create a self-signed certificate with
+##
+##   openssl req -x509 -newkey rsa:2048 -nodes -subj /CN=127.0.0.1 \
+##       -addext subjectAltName=IP:127.0.0.1 -keyout key.pem -out cert.pem
+##
+## Fixtures are a JSON object mapping method names to the "result" returned,
+## e.g. recorded from the live service. Statistics are printed every --report
+## seconds and on exit.
+
+import argparse
+import ctypes
+import ctypes.util
+import io
+import json
+import random
+import signal
+import ssl
+import sys
+import threading
+import time
+import wave
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+from urllib.parse import parse_qs, urlparse
+
+# pandora error codes, see src/libpiano/piano.h
+INTERNAL = 0
+INVALID_AUTH_TOKEN = 1001
+
+
+class Blowfish:
+    """ECB mode Blowfish, hex-encoded, like PianoEncryptString """
+
+    GCRY_CIPHER_BLOWFISH = 4
+    GCRY_CIPHER_MODE_ECB = 1
+
+    lib = None
+
+    def __init__(self, key):
+        if Blowfish.lib is None:
+            Blowfish.lib = ctypes.CDLL(ctypes.util.find_library('gcrypt'))
+            Blowfish.lib.gcry_check_version.restype = ctypes.c_char_p
+            Blowfish.lib.gcry_check_version(None)
+        self.handle = ctypes.c_void_p()
+        self.check(Blowfish.lib.gcry_cipher_open(ctypes.byref(self.handle),
+                self.GCRY_CIPHER_BLOWFISH, self.GCRY_CIPHER_MODE_ECB, 0))
+        key = key.encode()
+        self.check(Blowfish.lib.gcry_cipher_setkey(self.handle, key,
+                len(key)))
+        self.lock = threading.Lock()
+
+    @staticmethod
+    def check(err):
+        if err != 0:
+            raise RuntimeError('gcrypt error {}'.format(err))
+
+    def run(self, func, data):
+        buf = ctypes.create_string_buffer(data, len(data))
+        with self.lock:
+            self.check(func(self.handle, buf, len(data), None, 0))
+        return buf.raw
+
+    def encrypt(self, data):
+        if len(data) % 8 != 0:
+            data += b'\0' * (8 - len(data) % 8)
+        return self.run(Blowfish.lib.gcry_cipher_encrypt, data).hex()
+
+    def decrypt(self, hexdata):
+        return self.run(Blowfish.lib.gcry_cipher_decrypt,
+                bytes.fromhex(hexdata)).rstrip(b'\0')
+
+
+def defaultFixtures(args):
+    stations = [{
+            'stationName': 'Mock Station {}'.format(i),
+            'stationToken': str(1000 + i),
+            'stationId': str(1000 + i),
+            'isShared': False,
+            'isQuickMix': False,
+            } for i in range(args.stations)]
+    return {
+            'user.getStationList': {'stations': stations, 'checksum': 'mock'},
+            'station.getPlaylist': None,
+            'music.search': {'songs': [], 'artists': [], 'genreStations': []},
+            'station.getGenreStations': {'categories': []},
+            'track.explainTrack': {'explanations': [
+                    {'focusTraitName': 'mock data'}]},
+            'user.getSettings': {'gender': 'male', 'birthYear': 1980,
+                    'zipCode': '00000', 'isProfilePrivate': False,
+                    'enableComments': False, 'emailOptIn': False,
+                    'isExplicitContentFilterEnabled': False},
+            }
+
+
+def silence(seconds):
+    out = io.BytesIO()
+    with wave.open(out, 'wb') as w:
+        w.setnchannels(2)
+        w.setsampwidth(2)
+        w.setframerate(44100)
+        w.writeframes(b'\0' * 4 * 44100 * seconds)
+    return out.getvalue()
+
+
+class Stats:
+    def __init__(self):
+        self.lock = threading.Lock()
+        self.start = time.monotonic()
+        self.latency = {}
+        self.errors = 0
+
+    def add(self, method, seconds, failed):
+        with self.lock:
+            self.latency.setdefault(method, []).append(seconds)
+            self.errors += failed
+
+    @staticmethod
+    def percentile(values, p):
+        return values[min(len(values) - 1, int(len(values) * p / 100))]
+
+    def report(self, out=sys.stderr):
+        with self.lock:
+            elapsed = time.monotonic() - self.start
+            total = sum(len(v) for v in self.latency.values())
+            print('{} calls in {:.1f} s, {:.2f} calls/s, {} errors injected'
+                    .format(total, elapsed, total / elapsed, self.errors),
+                    file=out)
+            for method, values in sorted(self.latency.items()):
+                values = sorted(values)
+                print('  {:32s} {:6d}  p50 {:7.1f} ms  p90 {:7.1f} ms  '
+                        'p99 {:7.1f} ms'.format(method, len(values),
+                        *(self.percentile(values, p) * 1000
+                        for p in (50, 90, 99))), file=out)
+
+
+class Handler(BaseHTTPRequestHandler):
+    protocol_version = 'HTTP/1.1'
+    server_version = 'mockpandora'
+    # headers and body are written separately, do not wait for the ack
+    disable_nagle_algorithm = True
+
+    def log_message(self, fmt, *args):
+        if self.server.args.verbose:
+            super().log_message(fmt, *args)
+
+    def reply(self, body, contentType='application/json'):
+        self.send_response(200)
+        self.send_header('Content-Type', contentType)
+        self.send_header('Content-Length', str(len(body)))
+        self.end_headers()
+        self.wfile.write(body)
+
+    def do_GET(self):
+        if self.path.startswith('/audio/'):
+            self.reply(self.server.audio, 'audio/wav')
+        else:
+            self.send_error(404)
+
+    def do_POST(self):
+        state = self.server.state
+        args = state.args
+        start = time.monotonic()
+
+        query = parse_qs(urlparse(self.path).query)
+        method = query.get('method', [''])[0]
+        body = self.rfile.read(int(self.headers.get('Content-Length', 0)))
+
+        delay = args.latency + random.uniform(0, args.jitter)
+        time.sleep(delay / 1000)
+
+        failed = random.random() < args.error_rate
+        if failed:
+            response = {'stat': 'fail', 'message': 'injected error',
+                    'code': args.error_code}
+        else:
+            try:
+                response = state.call(method, query, body)
+            except Exception as e:
+                response = {'stat': 'fail', 'message': str(e),
+                        'code': INTERNAL}
+        self.reply(json.dumps(response).encode())
+
+        state.stats.add(method, time.monotonic() - start, failed)
+
+
+class State:
+    def __init__(self, args):
+        self.args = args
+        self.encrypt = Blowfish(args.decrypt_password)
+        self.decrypt = Blowfish(args.encrypt_password)
+        self.fixtures = defaultFixtures(args)
+        if args.fixtures:
+            with open(args.fixtures) as fd:
+                self.fixtures.update(json.load(fd))
+        self.lock = threading.Lock()
+        # user auth token -> issue time
+        self.tokens = {}
+        self.serial = 0
+        self.stats = Stats()
+
+    def checkToken(self, query):
+        token = query.get('auth_token', [''])[0]
+        with self.lock:
+            issued = self.tokens.get(token)
+        ttl = self.args.token_ttl
+        return issued is not None and (ttl <= 0 or
+                time.monotonic() - issued < ttl)
+
+    def playlist(self):
+        items = []
+        with self.lock:
+            base = self.serial
+            self.serial += 4
+        audioUrl = 'http://{}:{}/audio/'.format(self.args.host,
+                self.args.http_port)
+        for i in range(base, base + 4):
+            url = {'audioUrl': audioUrl + '{}.wav'.format(i),
+                    'encoding': 'mp3', 'bitrate': '128'}
+            items.append({
+                    'artistName': 'Mock Artist {}'.format(i % 7),
+                    'albumName': 'Mock Album {}'.format(i % 3),
+                    'songName': 'Mock Song {}'.format(i),
+                    'trackToken': 'track{}'.format(i),
+                    'stationId': '1000',
+                    'albumArtUrl': '',
+                    'songDetailUrl': '',
+                    'trackGain': '0.0',
+                    'trackLength': self.args.song_seconds,
+                    'songRating': 0,
+                    'audioUrlMap': {'lowQuality': url, 'mediumQuality': url,
+                            'highQuality': url},
+                    })
+        return {'items': items}
+
+    def call(self, method, query, body):
+        if method == 'auth.partnerLogin':
+            # four bytes of garbage, then the server time
+            sync = self.encrypt.encrypt(b'mock' +
+                    str(int(time.time())).encode())
+            return {'stat': 'ok', 'result': {'syncTime': sync,
+                    'partnerAuthToken': 'partner', 'partnerId': 42}}
+
+        request = json.loads(self.decrypt.decrypt(body.decode()))
+        if method == 'auth.userLogin':
+            with self.lock:
+                self.serial += 1
+                token = 'user{}'.format(self.serial)
+                self.tokens[token] = time.monotonic()
+            return {'stat': 'ok', 'result': {'userId': '1',
+                    'userAuthToken': token,
+                    'username': request.get('username')}}
+
+        if not self.checkToken(query):
+            return {'stat': 'fail', 'message': 'invalid auth token',
+                    'code': INVALID_AUTH_TOKEN}
+
+        result = self.fixtures.get(method, {})
+        if method == 'station.getPlaylist' and result is None:
+            result = self.playlist()
+        return {'stat': 'ok', 'result': result}
+
+
+def serve(state, port, context=None):
+    server = ThreadingHTTPServer((state.args.host, port), Handler)
+    server.state = state
+    server.args = state.args
+    server.audio = silence(state.args.song_seconds)
+    if context is not None:
+        server.socket = context.wrap_socket(server.socket, server_side=True)
+    thread = threading.Thread(target=server.serve_forever, daemon=True)
+    thread.start()
+    return server
+
+
+def main():
+    parser = argparse.ArgumentParser(description=
+            'Local stand-in for the Pandora JSON API')
+    parser.add_argument('--host', default='127.0.0.1')
+    parser.add_argument('--http-port', type=int, default=8080,
+            help='rpc_port')
+    parser.add_argument('--https-port', type=int, default=8443,
+            help='rpc_tls_port')
+    parser.add_argument('--cert', help='certificate for https')
+    parser.add_argument('--key', help='private key for https')
+    parser.add_argument('--fixtures', help='JSON file, method -> result')
+    parser.add_argument('--latency', type=float, default=0,
+            help='added to every call, milliseconds')
+    parser.add_argument('--jitter', type=float, default=0,
+            help='random extra latency up to this, milliseconds')
+    parser.add_argument('--error-rate', type=float, default=0,
+            help='probability of failing a call, 0..1')
+    parser.add_argument('--error-code', type=int, default=INTERNAL,
+            help='pandora error code of failed calls')
+    parser.add_argument('--token-ttl', type=float, default=0,
+            help='user auth tokens expire after this many seconds')
+    parser.add_argument('--stations', type=int, default=3)
+    parser.add_argument('--song-seconds', type=int, default=30)
+    parser.add_argument('--report', type=float, default=0,
+            help='print statistics every this many seconds')
+    parser.add_argument('--encrypt-password', default='6#26FRL$ZWD')
+    parser.add_argument('--decrypt-password', default='R=U!LH$O2B#')
+    parser.add_argument('--verbose', action='store_true')
+    args = parser.parse_args()
+
+    state = State(args)
+    serve(state, args.http_port)
+    if args.cert:
+        context = ssl.SSLContext(ssl.PROTOCOL_TLS_SERVER)
+        context.load_cert_chain(args.cert, args.key)
+        serve(state, args.https_port, context)
+    else:
+        print('no --cert given, https calls will fail', file=sys.stderr)
+
+    done = threading.Event()
+    signal.signal(signal.SIGINT, lambda *a: done.set())
+    signal.signal(signal.SIGTERM, lambda *a: done.set())
+    while not done.wait(args.report or None):
+        state.stats.report()
+    state.stats.report()
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,227 @@
+/*
+Copyright (c) 2026
+        pianobar contributors
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+
+/* on-disk copy of pandora's genre station catalog, which rarely changes. One
+ * line per category or genre:
+ *
+ *	c<tab>name
+ *	g<tab>token<tab>name
+ */
+
+#include "config.h"
+
+#include <assert.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "genres.h"
+
+#define BAR_GENRES_MAGIC "pianobar genres 1\n"
+
+/*	split next line off the mapped file
+ *	@param current position, advanced past the line
+ *	@param end of data
+ *	@param line length
+ *	@return start of line or NULL at the end
+ */
+static const char *BarGenresLine(const char **const pos,
+                                 const char *const end, size_t *const len) {
+    const char *const line = *pos;
+    if (line >= end) {
+        return NULL;
+    }
+    const char *const nl = memchr(line, '\n', end - line);
+    if (nl == NULL) {
+        /* truncated */
+        return NULL;
+    }
+    *len = nl - line;
+    *pos = nl + 1;
+    return line;
+}
+
+/*	parse mapped cache file
+ *	@return categories or NULL if the file is invalid
+ */
+static PianoGenreCategory_t *BarGenresParse(const char *pos,
+                                            const char *const end) {
+    PianoGenreCategory_t *categories = NULL, *cat = NULL;
+    PianoListHead_t *catTail = NULL, *genreTail = NULL;
+    const char *line;
+    size_t len;
+
+    while ((line = BarGenresLine(&pos, end, &len)) != NULL) {
+        if (len < 2 || line[1] != '\t') {
+            continue;
+        }
+        const char *const field = line + 2;
+        const size_t fieldLen = len - 2;
+
+        if (line[0] == 'c') {
+            /* genres of a category that cannot be added are dropped as
+             * well, instead of ending up in the previous one */
+            genreTail = NULL;
+            if ((cat = calloc(1, sizeof(*cat))) == NULL) {
+                continue;
+            }
+            if ((cat->name = strndup(field, fieldLen)) == NULL) {
+                free(cat);
+                cat = NULL;
+                continue;
+            }
+            categories = PianoListAppendTailP(categories, &catTail, cat);
+        } else if (line[0] == 'g' && cat != NULL) {
+            const char *const tab = memchr(field, '\t', fieldLen);
+            PianoGenre_t *genre;
+            if (tab == NULL || (genre = calloc(1, sizeof(*genre))) == NULL) {
+                continue;
+            }
+            genre->musicId = strndup(field, tab - field);
+            genre->name = strndup(tab + 1, field + fieldLen - (tab + 1));
+            if (genre->musicId == NULL || genre->name == NULL) {
+                free(genre->musicId);
+                free(genre->name);
+                free(genre);
+                continue;
+            }
+            cat->genres = PianoListAppendTailP(cat->genres, &genreTail, genre);
+        }
+    }
+
+    return categories;
+}
+
+/*	load genre catalog, if there is one
+ *	@param categories, set on success
+ *	@param cache file
+ *	@param maximum age in seconds, 0 disables the cache
+ *	@param set to true if the catalog is older than that and should be
+ *	       refreshed
+ *	@return true if categories were loaded
+ */
+bool BarGenresLoad(PianoGenreCategory_t **const categories,
+                   const char *const path, const unsigned int ttl,
+                   bool *const stale) {
+    assert(categories != NULL);
+    assert(path != NULL);
+    assert(stale != NULL);
+
+    if (ttl == 0) {
+        return false;
+    }
+
+    const int fd = open(path, O_RDONLY);
+    if (fd == -1) {
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) == -1 || st.st_size < (off_t)strlen(BAR_GENRES_MAGIC)) {
+        close(fd);
+        return false;
+    }
+    const char *const map =
+        mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        return false;
+    }
+
+    const char *const end = map + st.st_size;
+    const size_t magicLen = strlen(BAR_GENRES_MAGIC);
+    PianoGenreCategory_t *parsed = NULL;
+    if (memcmp(map, BAR_GENRES_MAGIC, magicLen) == 0) {
+        parsed = BarGenresParse(map + magicLen, end);
+    }
+    munmap((void *)map, st.st_size);
+
+    if (parsed == NULL) {
+        return false;
+    }
+
+    /* files written in the future are stale too */
+    const time_t now = time(NULL);
+    *stale = st.st_mtime > now || now - st.st_mtime >= (time_t)ttl;
+    *categories = parsed;
+    return true;
+}
+
+/*	write genre catalog, atomically
+ *	@param categories
+ *	@param cache file
+ */
+void BarGenresSave(const PianoGenreCategory_t *categories,
+                   const char *const path) {
+    assert(path != NULL);
+
+    if (categories == NULL) {
+        return;
+    }
+
+    const size_t pathLen = strlen(path) + 5;
+    char *const tmpPath = malloc(pathLen);
+    if (tmpPath == NULL) {
+        return;
+    }
+    snprintf(tmpPath, pathLen, "%s.tmp", path);
+
+    FILE *const fp = fopen(tmpPath, "w");
+    if (fp == NULL) {
+        free(tmpPath);
+        return;
+    }
+
+    fputs(BAR_GENRES_MAGIC, fp);
+    PianoListForeachP(categories) {
+        /* skips the category's genres too, they would be attached to the
+         * previous category when loading */
+        if (categories->name == NULL ||
+            strpbrk(categories->name, "\t\n") != NULL) {
+            continue;
+        }
+        fprintf(fp, "c\t%s\n", categories->name);
+        const PianoGenre_t *genre = categories->genres;
+        PianoListForeachP(genre) {
+            if (genre->name == NULL || genre->musicId == NULL ||
+                strpbrk(genre->name, "\t\n") != NULL ||
+                strpbrk(genre->musicId, "\t\n") != NULL) {
+                continue;
+            }
+            fprintf(fp, "g\t%s\t%s\n", genre->musicId, genre->name);
+        }
+    }
+
+    const bool ok = !ferror(fp);
+    if (fclose(fp) == 0 && ok) {
+        rename(tmpPath, path);
+    } else {
+        unlink(tmpPath);
+    }
+    free(tmpPath);
+}
@@ -0,0 +1,407 @@
+/*
+Copyright (c) 2026
+        pianobar contributors
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+
+/* Ratings, bookmarks and tired songs are sent in the background. They are
+ * appended to a journal file first, so nothing is lost if pianobar quits or
+ * the network is down, and sent with retries. The file has one line per
+ * entry and one per entry sent:
+ *
+ *	a seq type stationId trackToken title
+ *	d seq
+ */
+
+#include "config.h"
+
+#include <assert.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "journal.h"
+#include "ui.h"
+
+/* entries sent at the same time */
+#define BAR_JOURNAL_INFLIGHT 4
+/* longest pause between two attempts, seconds */
+#define BAR_JOURNAL_MAXBACKOFF 300
+
+static const char *const typeNames[BAR_JOURNAL_COUNT] = {
+    [BAR_JOURNAL_LOVE] = "love",
+    [BAR_JOURNAL_BAN] = "ban",
+    [BAR_JOURNAL_TIRED] = "tired",
+    [BAR_JOURNAL_BOOKMARK_SONG] = "bookmarksong",
+    [BAR_JOURNAL_BOOKMARK_ARTIST] = "bookmarkartist",
+};
+
+static const PianoRequestType_t requestTypes[BAR_JOURNAL_COUNT] = {
+    [BAR_JOURNAL_LOVE] = PIANO_REQUEST_RATE_SONG,
+    [BAR_JOURNAL_BAN] = PIANO_REQUEST_RATE_SONG,
+    [BAR_JOURNAL_TIRED] = PIANO_REQUEST_ADD_TIRED_SONG,
+    [BAR_JOURNAL_BOOKMARK_SONG] = PIANO_REQUEST_BOOKMARK_SONG,
+    [BAR_JOURNAL_BOOKMARK_ARTIST] = PIANO_REQUEST_BOOKMARK_ARTIST,
+};
+
+/*	create entry and append it to the list
+ */
+static BarJournalEntry_t *BarJournalNew(BarJournal_t *const j,
+                                        const unsigned long seq,
+                                        const BarJournalType_t type,
+                                        const char *const stationId,
+                                        const char *const trackToken,
+                                        const char *const title) {
+    BarJournalEntry_t *const e = calloc(1, sizeof(*e));
+    if (e == NULL) {
+        return NULL;
+    }
+    e->journal = j;
+    e->seq = seq;
+    e->type = type;
+    e->song.stationId = stationId != NULL ? strdup(stationId) : NULL;
+    e->song.trackToken = strdup(trackToken);
+    e->song.title = title != NULL ? strdup(title) : NULL;
+    e->rate.song = &e->song;
+    e->rate.rating = type == BAR_JOURNAL_BAN ? PIANO_RATE_BAN : PIANO_RATE_LOVE;
+
+    BarJournalEntry_t **last = &j->entries;
+    while (*last != NULL) {
+        last = &(*last)->next;
+    }
+    *last = e;
+
+    return e;
+}
+
+static void BarJournalFree(BarJournalEntry_t *const e) {
+    free(e->song.stationId);
+    free(e->song.trackToken);
+    free(e->song.title);
+    free(e);
+}
+
+/*	write entry line
+ */
+static void BarJournalWrite(FILE *const fp, const BarJournalEntry_t *const e) {
+    const char *const title = e->song.title;
+    fprintf(fp, "a %lu %s %s %s %s\n", e->seq, typeNames[e->type],
+            e->song.stationId != NULL ? e->song.stationId : "-",
+            e->song.trackToken,
+            title != NULL && strchr(title, '\n') == NULL ? title : "-");
+}
+
+/*	open journal file for appending, readable by the current user only
+ */
+static FILE *BarJournalOpen(const char *const path, const int flags) {
+    const int fd = open(path, O_WRONLY | O_CREAT | flags, 0600);
+    if (fd == -1) {
+        return NULL;
+    }
+    FILE *const fp = fdopen(fd, "a");
+    if (fp == NULL) {
+        close(fd);
+    }
+    return fp;
+}
+
+/*	replace journal file with the entries not sent yet
+ */
+static void BarJournalCompact(BarJournal_t *const j) {
+    const char *const path = j->settings->journalFile;
+    const size_t pathLen = strlen(path) + 5;
+    char *const tmpPath = malloc(pathLen);
+    snprintf(tmpPath, pathLen, "%s.tmp", path);
+
+    FILE *const fp = BarJournalOpen(tmpPath, O_TRUNC);
+    if (fp == NULL) {
+        free(tmpPath);
+        return;
+    }
+    j->lines = 0;
+    for (const BarJournalEntry_t *e = j->entries; e != NULL; e = e->next) {
+        BarJournalWrite(fp, e);
+        ++j->lines;
+    }
+    if (fflush(fp) != 0 || fsync(fileno(fp)) != 0 ||
+        rename(tmpPath, path) != 0) {
+        fclose(fp);
+        unlink(tmpPath);
+        free(tmpPath);
+        return;
+    }
+    free(tmpPath);
+
+    if (j->fp != NULL) {
+        fclose(j->fp);
+    }
+    j->fp = fp;
+}
+
+/*	read entries not sent by the last session
+ */
+static void BarJournalLoad(BarJournal_t *const j) {
+    FILE *const fp = fopen(j->settings->journalFile, "r");
+    if (fp == NULL) {
+        return;
+    }
+
+    char *line = NULL;
+    size_t size = 0;
+    ssize_t len;
+    while ((len = getline(&line, &size, fp)) != -1) {
+        if (len > 0 && line[len - 1] == '\n') {
+            line[len - 1] = '\0';
+        }
+
+        char *save = NULL;
+        const char *const op = strtok_r(line, " ", &save);
+        const char *const seqStr = strtok_r(NULL, " ", &save);
+        if (op == NULL || seqStr == NULL) {
+            continue;
+        }
+        const unsigned long seq = strtoul(seqStr, NULL, 10);
+        if (seq > j->seq) {
+            j->seq = seq;
+        }
+
+        if (strcmp(op, "a") == 0) {
+            const char *const typeStr = strtok_r(NULL, " ", &save);
+            const char *const stationId = strtok_r(NULL, " ", &save);
+            const char *const trackToken = strtok_r(NULL, " ", &save);
+            const char *const title = strtok_r(NULL, "", &save);
+            if (typeStr == NULL || stationId == NULL || trackToken == NULL) {
+                continue;
+            }
+            const bool noStation = strcmp(stationId, "-") == 0;
+            for (size_t i = 0; i < BAR_JOURNAL_COUNT; i++) {
+                /* ratings need the station */
+                const bool rating = requestTypes[i] == PIANO_REQUEST_RATE_SONG;
+                if (strcmp(typeStr, typeNames[i]) == 0 &&
+                    (!rating || !noStation)) {
+                    BarJournalNew(j, seq, i, noStation ? NULL : stationId,
+                                  trackToken, title);
+                    break;
+                }
+            }
+        } else if (strcmp(op, "d") == 0) {
+            BarJournalEntry_t **prev = &j->entries;
+            while (*prev != NULL && (*prev)->seq != seq) {
+                prev = &(*prev)->next;
+            }
+            if (*prev != NULL) {
+                BarJournalEntry_t *const e = *prev;
+                *prev = e->next;
+                BarJournalFree(e);
+            }
+        }
+    }
+    free(line);
+    fclose(fp);
+}
+
+/*	set up journal and pick up what the last session did not send
+ */
+void BarJournalInit(BarJournal_t *const j, BarRpc_t *const rpc,
+                    const BarSettings_t *const settings) {
+    assert(j != NULL);
+    assert(rpc != NULL);
+    assert(settings != NULL);
+    assert(settings->journalFile != NULL);
+
+    memset(j, 0, sizeof(*j));
+    j->rpc = rpc;
+    j->settings = settings;
+
+    BarJournalLoad(j);
+    BarJournalCompact(j);
+    if (j->fp == NULL) {
+        BarUiMsg(settings, MSG_ERR,
+                 "Cannot open journal %s, feedback is not saved.\n",
+                 settings->journalFile);
+    }
+}
+
+/*	stop sending, entries not sent yet stay in the file
+ */
+void BarJournalDestroy(BarJournal_t *const j) {
+    assert(j != NULL);
+
+    BarJournalEntry_t *e = j->entries;
+    while (e != NULL) {
+        BarJournalEntry_t *const next = e->next;
+        BarRpcCancel(j->rpc, e->call);
+        BarJournalFree(e);
+        e = next;
+    }
+    if (j->fp != NULL) {
+        fclose(j->fp);
+    }
+    memset(j, 0, sizeof(*j));
+}
+
+/*	queue feedback for a song, returns immediately
+ *	@param journal
+ *	@param what to send
+ *	@param song, copied
+ *	@return false if it cannot be queued
+ */
+bool BarJournalAdd(BarJournal_t *const j, const BarJournalType_t type,
+                   const PianoSong_t *const song) {
+    assert(j != NULL);
+    assert(type < BAR_JOURNAL_COUNT);
+    assert(song != NULL);
+    assert(song->trackToken != NULL);
+
+    BarJournalEntry_t *const e = BarJournalNew(
+        j, ++j->seq, type, song->stationId, song->trackToken, song->title);
+    if (e == NULL) {
+        return false;
+    }
+
+    /* must survive a crash, unlike the note that it was sent */
+    if (j->fp != NULL) {
+        BarJournalWrite(j->fp, e);
+        fflush(j->fp);
+        fsync(fileno(j->fp));
+        ++j->lines;
+    }
+
+    return true;
+}
+
+/*	failures worth trying again later
+ */
+static bool BarJournalTransient(const BarRpcCall_t *const call) {
+    if (call->wRet != CURLE_OK) {
+        return true;
+    }
+    switch (call->pRet) {
+        case PIANO_RET_ERR:
+        case PIANO_RET_INVALID_RESPONSE:
+        case PIANO_RET_OUT_OF_MEMORY:
+        case PIANO_RET_P_INTERNAL:
+        case PIANO_RET_P_MAINTENANCE_MODE:
+        case PIANO_RET_P_READ_ONLY_MODE:
+        case PIANO_RET_P_INSUFFICIENT_CONNECTIVITY:
+        case PIANO_RET_P_INVALID_AUTH_TOKEN:
+        case PIANO_RET_P_RATE_LIMIT:
+            return true;
+
+        default:
+            return false;
+    }
+}
+
+static void BarJournalDone(BarRpcCall_t *const call, void *const data) {
+    BarJournalEntry_t *const e = data;
+    BarJournal_t *const j = e->journal;
+
+    e->call = NULL;
+    --j->inFlight;
+
+    if (call->pRet != PIANO_RET_OK || call->wRet != CURLE_OK) {
+        if (BarJournalTransient(call)) {
+            /* exponential backoff */
+            unsigned int backoff = BAR_JOURNAL_MAXBACKOFF;
+            if (e->attempts < 9 && (1u << e->attempts) < backoff) {
+                backoff = 1u << e->attempts;
+            }
+            e->retryAt = time(NULL) + backoff;
+            ++e->attempts;
+            ++j->retried;
+            return;
+        }
+        BarUiMsg(j->settings, MSG_ERR, "Cannot send %s for \"%s\": %s\n",
+                 typeNames[e->type], e->song.title != NULL ? e->song.title : "",
+                 PianoErrorToStr(call->pRet));
+        ++j->dropped;
+    } else {
+        ++j->sent;
+    }
+
+    BarJournalEntry_t **prev = &j->entries;
+    while (*prev != e) {
+        assert(*prev != NULL);
+        prev = &(*prev)->next;
+    }
+    *prev = e->next;
+
+    if (j->fp != NULL) {
+        if (j->entries == NULL) {
+            /* everything sent, start over */
+            BarJournalCompact(j);
+        } else {
+            fprintf(j->fp, "d %lu\n", e->seq);
+            fflush(j->fp);
+        }
+    }
+    BarJournalFree(e);
+}
+
+/*	send entries that are due. Entries for the same song are sent in order.
+ */
+void BarJournalFlush(BarJournal_t *const j) {
+    assert(j != NULL);
+
+    /* not logged in yet */
+    if (j->rpc->ph->user.authToken == NULL) {
+        return;
+    }
+
+    const time_t now = time(NULL);
+    for (BarJournalEntry_t *e = j->entries;
+         e != NULL && j->inFlight < BAR_JOURNAL_INFLIGHT; e = e->next) {
+        if (e->call != NULL || e->retryAt > now) {
+            continue;
+        }
+        bool blocked = false;
+        for (const BarJournalEntry_t *o = j->entries; o != e; o = o->next) {
+            if (strcmp(o->song.trackToken, e->song.trackToken) == 0) {
+                blocked = true;
+                break;
+            }
+        }
+        if (blocked) {
+            continue;
+        }
+
+        void *const reqData = requestTypes[e->type] == PIANO_REQUEST_RATE_SONG
+                                  ? (void *)&e->rate
+                                  : (void *)&e->song;
+        e->call = BarRpcSubmit(j->rpc, requestTypes[e->type], reqData, NULL,
+                               BarJournalDone, e);
+        if (e->call != NULL) {
+            ++j->inFlight;
+        }
+    }
+}
+
+/*	number of entries not sent yet
+ */
+unsigned int BarJournalPending(const BarJournal_t *const j) {
+    unsigned int n = 0;
+    for (const BarJournalEntry_t *e = j->entries; e != NULL; e = e->next) {
+        ++n;
+    }
+    return n;
+}
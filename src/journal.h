@@ -0,0 +1,82 @@
+/*
+Copyright (c) 2026
+        pianobar contributors
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+
+#pragma once
+
+#include "config.h"
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <time.h>
+
+#include <piano.h>
+
+#include "rpc.h"
+#include "settings.h"
+
+typedef enum {
+    BAR_JOURNAL_LOVE = 0,
+    BAR_JOURNAL_BAN = 1,
+    BAR_JOURNAL_TIRED = 2,
+    BAR_JOURNAL_BOOKMARK_SONG = 3,
+    BAR_JOURNAL_BOOKMARK_ARTIST = 4,
+    BAR_JOURNAL_COUNT = 5,
+} BarJournalType_t;
+
+struct BarJournal;
+
+typedef struct BarJournalEntry {
+    struct BarJournalEntry *next;
+    struct BarJournal *journal;
+    unsigned long seq;
+    BarJournalType_t type;
+    /* copy of the fields needed, the song itself may be gone when the entry
+     * is sent */
+    PianoSong_t song;
+    PianoRequestDataRateSong_t rate;
+    /* in flight if not NULL */
+    BarRpcCall_t *call;
+    unsigned int attempts;
+    time_t retryAt;
+} BarJournalEntry_t;
+
+/* feedback not sent to pandora yet, kept in a file until it is */
+typedef struct BarJournal {
+    /* oldest first */
+    BarJournalEntry_t *entries;
+    BarRpc_t *rpc;
+    const BarSettings_t *settings;
+    FILE *fp;
+    unsigned long seq;
+    unsigned int inFlight;
+    /* entries written to the file, it is truncated once all are sent */
+    unsigned long lines;
+    unsigned int sent, retried, dropped;
+} BarJournal_t;
+
+void BarJournalInit(BarJournal_t *, BarRpc_t *, const BarSettings_t *);
+void BarJournalDestroy(BarJournal_t *);
+bool BarJournalAdd(BarJournal_t *, BarJournalType_t, const PianoSong_t *);
+void BarJournalFlush(BarJournal_t *);
+unsigned int BarJournalPending(const BarJournal_t *);
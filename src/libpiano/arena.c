@@ -0,0 +1,171 @@
+/*
+Copyright (c) 2026
+        pianobar contributors
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/* reference-counted bump allocator for records parsed from one response */
+
+#include "../config.h"
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "piano_private.h"
+
+/* large enough for a whole playlist */
+#define PIANO_ARENA_CHUNK 8192
+
+typedef union {
+	long double ld;
+	long long ll;
+	void *p;
+} PianoArenaAlign_t;
+
+typedef struct PianoArenaChunk {
+	struct PianoArenaChunk *next;
+	size_t size, used;
+	PianoArenaAlign_t data[];
+} PianoArenaChunk_t;
+
+struct PianoArena {
+	/* records allocated from the arena, plus one while it is filled */
+	unsigned int refs;
+	/* newest first, the arena itself lives in the oldest one */
+	PianoArenaChunk_t *chunks;
+};
+
+static PianoArenaChunk_t *PianoArenaChunkNew (const size_t size) {
+	PianoArenaChunk_t *chunk = malloc (sizeof (*chunk) + size);
+	if (chunk == NULL) {
+		return NULL;
+	}
+	chunk->next = NULL;
+	chunk->size = size;
+	chunk->used = 0;
+	return chunk;
+}
+
+/*	get uninitialized memory from arena
+ *	@param arena
+ *	@param size
+ *	@param alignment, power of two
+ *	@return memory or NULL if out of memory
+ */
+static void *PianoArenaGet (PianoArena_t *arena, const size_t size,
+		const size_t align) {
+	PianoArenaChunk_t *chunk = arena->chunks;
+	size_t offset = (chunk->used + align - 1) & ~(align - 1);
+
+	if (offset > chunk->size || chunk->size - offset < size) {
+		chunk = PianoArenaChunkNew (size > PIANO_ARENA_CHUNK ? size :
+				PIANO_ARENA_CHUNK);
+		if (chunk == NULL) {
+			return NULL;
+		}
+		chunk->next = arena->chunks;
+		arena->chunks = chunk;
+		offset = 0;
+	}
+
+	chunk->used = offset + size;
+	return (char *) chunk->data + offset;
+}
+
+/*	create arena, the caller holds a reference
+ *	@return arena or NULL if out of memory
+ */
+PianoArena_t *PianoArenaNew (void) {
+	PianoArenaChunk_t *chunk = PianoArenaChunkNew (PIANO_ARENA_CHUNK);
+	if (chunk == NULL) {
+		return NULL;
+	}
+
+	PianoArena_t *arena = (PianoArena_t *) chunk->data;
+	chunk->used = sizeof (*arena);
+	arena->refs = 1;
+	arena->chunks = chunk;
+	return arena;
+}
+
+/*	allocate zeroed, suitably aligned memory for a record
+ *	@param arena
+ *	@param size
+ *	@return memory or NULL if out of memory
+ */
+void *PianoArenaAlloc (PianoArena_t *arena, const size_t size) {
+	assert (arena != NULL);
+
+	void *p = PianoArenaGet (arena, size, sizeof (PianoArenaAlign_t));
+	if (p != NULL) {
+		memset (p, 0, size);
+	}
+	return p;
+}
+
+/*	copy string into arena
+ *	@param arena
+ *	@param string, may be NULL
+ *	@return copy, NULL if s is NULL or out of memory
+ */
+char *PianoArenaStrdup (PianoArena_t *arena, const char *s) {
+	assert (arena != NULL);
+
+	if (s == NULL) {
+		return NULL;
+	}
+
+	const size_t size = strlen (s) + 1;
+	char *copy = PianoArenaGet (arena, size, 1);
+	if (copy != NULL) {
+		memcpy (copy, s, size);
+	}
+	return copy;
+}
+
+/*	take a reference, one for every record allocated from the arena. Not
+ *	thread-safe, like the rest of libpiano.
+ */
+void PianoArenaRef (PianoArena_t *arena) {
+	assert (arena != NULL);
+	assert (arena->refs > 0);
+
+	++arena->refs;
+}
+
+/*	drop a reference, frees the arena when the last one is gone
+ */
+void PianoArenaUnref (PianoArena_t *arena) {
+	assert (arena != NULL);
+	assert (arena->refs > 0);
+
+	if (--arena->refs > 0) {
+		return;
+	}
+
+	/* arena is part of the last chunk, do not touch it while freeing */
+	PianoArenaChunk_t *chunk = arena->chunks;
+	while (chunk != NULL) {
+		PianoArenaChunk_t *next = chunk->next;
+		free (chunk);
+		chunk = next;
+	}
+}
@@ -0,0 +1,192 @@
+/*
+Copyright (c) 2026
+        pianobar contributors
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/* reference-counted table of strings that repeat across songs, like artist
+ * names and station ids */
+
+#include "../config.h"
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "piano_private.h"
+
+typedef struct PianoInternString {
+	struct PianoInternString *next;
+	struct PianoInternTable *table;
+	unsigned int refs;
+	uint32_t hash;
+	char str[];
+} PianoInternString_t;
+
+struct PianoInternTable {
+	/* chained buckets, power of two */
+	PianoInternString_t **buckets;
+	size_t size, count;
+	/* handle is gone, free table with the last string */
+	bool orphaned;
+};
+
+/*	FNV-1a
+ */
+static uint32_t PianoInternHash (const char *s) {
+	uint32_t h = 2166136261u;
+	for (; *s != '\0'; s++) {
+		h = (h ^ (unsigned char) *s) * 16777619u;
+	}
+	return h;
+}
+
+static PianoInternString_t *PianoInternFromStr (const char *s) {
+	return (PianoInternString_t *) (s - offsetof (PianoInternString_t, str));
+}
+
+static void PianoInternTableFree (PianoInternTable_t *table) {
+	free (table->buckets);
+	free (table);
+}
+
+/*	double the number of buckets
+ *	@return false if out of memory
+ */
+static bool PianoInternGrow (PianoInternTable_t *table) {
+	const size_t size = table->size == 0 ? 64 : table->size * 2;
+	PianoInternString_t **buckets = calloc (size, sizeof (*buckets));
+	if (buckets == NULL) {
+		return false;
+	}
+
+	for (size_t i = 0; i < table->size; i++) {
+		PianoInternString_t *e = table->buckets[i];
+		while (e != NULL) {
+			PianoInternString_t *next = e->next;
+			const size_t k = e->hash & (size - 1);
+			e->next = buckets[k];
+			buckets[k] = e;
+			e = next;
+		}
+	}
+	free (table->buckets);
+	table->buckets = buckets;
+	table->size = size;
+	return true;
+}
+
+/*	get shared copy of string, release it with PianoInternRelease
+ *	@param piano handle, owns the table
+ *	@param string, may be NULL
+ *	@return shared copy, NULL if s is NULL or out of memory
+ */
+char *PianoIntern (PianoHandle_t *ph, const char *s) {
+	assert (ph != NULL);
+
+	if (s == NULL) {
+		return NULL;
+	}
+
+	PianoInternTable_t *table = ph->strings;
+	if (table == NULL) {
+		if ((table = calloc (1, sizeof (*table))) == NULL) {
+			return NULL;
+		}
+		ph->strings = table;
+	}
+	if (table->count >= table->size && !PianoInternGrow (table) &&
+			table->size == 0) {
+		return NULL;
+	}
+
+	const uint32_t hash = PianoInternHash (s);
+	PianoInternString_t **bucket = &table->buckets[hash & (table->size - 1)];
+	for (PianoInternString_t *e = *bucket; e != NULL; e = e->next) {
+		if (e->hash == hash && strcmp (e->str, s) == 0) {
+			++e->refs;
+			return e->str;
+		}
+	}
+
+	const size_t len = strlen (s);
+	PianoInternString_t *e = malloc (sizeof (*e) + len + 1);
+	if (e == NULL) {
+		return NULL;
+	}
+	memcpy (e->str, s, len + 1);
+	e->table = table;
+	e->refs = 1;
+	e->hash = hash;
+	e->next = *bucket;
+	*bucket = e;
+	++table->count;
+
+	return e->str;
+}
+
+/*	drop reference to string returned by PianoIntern
+ *	@param string, may be NULL
+ */
+void PianoInternRelease (char *s) {
+	if (s == NULL) {
+		return;
+	}
+
+	PianoInternString_t *e = PianoInternFromStr (s);
+	PianoInternTable_t *table = e->table;
+
+	assert (e->refs > 0);
+	if (--e->refs > 0) {
+		return;
+	}
+
+	PianoInternString_t **prev = &table->buckets[e->hash & (table->size - 1)];
+	while (*prev != e) {
+		assert (*prev != NULL);
+		prev = &(*prev)->next;
+	}
+	*prev = e->next;
+	free (e);
+
+	--table->count;
+	if (table->count == 0 && table->orphaned) {
+		PianoInternTableFree (table);
+	}
+}
+
+/*	detach table from handle, strings still in use keep it alive
+ *	@param piano handle
+ */
+void PianoInternDestroy (PianoHandle_t *ph) {
+	PianoInternTable_t *table = ph->strings;
+
+	if (table == NULL) {
+		return;
+	}
+	if (table->count == 0) {
+		PianoInternTableFree (table);
+	} else {
+		table->orphaned = true;
+	}
+	ph->strings = NULL;
+}
@@ -45,6 +45,33 @@ void *PianoListAppend (PianoListHead_t * const l, PianoListHead_t * const e) {
 	}
 }
 
+/*	append element e to list l in constant time, for building lists in a
+ *	loop. tail is the last element of l and updated; if it is NULL the end
+ *	of l is searched once.
+ */
+void *PianoListAppendTail (PianoListHead_t * const l,
+		PianoListHead_t ** const tail, PianoListHead_t * const e) {
+	assert (tail != NULL);
+	assert (e != NULL);
+	assert (e->next == NULL);
+
+	if (l == NULL) {
+		*tail = e;
+		return e;
+	}
+
+	if (*tail == NULL) {
+		*tail = l;
+		while ((*tail)->next != NULL) {
+			*tail = (*tail)->next;
+		}
+	}
+	assert ((*tail)->next == NULL);
+	(*tail)->next = e;
+	*tail = e;
+	return l;
+}
+
 /*	prepend element e to list l, returning new list head
  */
 void *PianoListPrepend (PianoListHead_t * const l, PianoListHead_t * const e) {
@@ -28,6 +28,7 @@ THE SOFTWARE.
 #include <stdlib.h>
 #include <assert.h>
 #include <stdint.h>
+#include <json.h>
 
 #include "piano_private.h"
 #include "piano.h"
@@ -72,11 +73,15 @@ static void PianoDestroyArtists (PianoArtist_t *artists) {
 
 	curArtist = artists;
 	while (curArtist != NULL) {
-		free (curArtist->name);
-		free (curArtist->musicId);
-		free (curArtist->seedId);
 		lastArtist = curArtist;
 		curArtist = (PianoArtist_t *) curArtist->head.next;
+		if (lastArtist->arena != NULL) {
+			PianoArenaUnref (lastArtist->arena);
+			continue;
+		}
+		free (lastArtist->name);
+		free (lastArtist->musicId);
+		free (lastArtist->seedId);
 		free (lastArtist);
 	}
 }
@@ -103,7 +108,7 @@ void PianoDestroyStation (PianoStation_t *station) {
 /*	free complete station list
  *	@param piano handle
  */
-static void PianoDestroyStations (PianoStation_t *stations) {
+void PianoDestroyStations (PianoStation_t *stations) {
 	PianoStation_t *curStation, *lastStation;
 
 	curStation = stations;
@@ -125,19 +130,27 @@ void PianoDestroyPlaylist (PianoSong_t *playlist) {
 
 	curSong = playlist;
 	while (curSong != NULL) {
-		free (curSong->audioUrl);
-		free (curSong->coverArt);
-		free (curSong->artist);
-		free (curSong->musicId);
-		free (curSong->title);
-		free (curSong->stationId);
-		free (curSong->album);
-		free (curSong->feedbackId);
-		free (curSong->seedId);
-		free (curSong->detailUrl);
-		free (curSong->trackToken);
 		lastSong = curSong;
 		curSong = (PianoSong_t *) curSong->head.next;
+		if (lastSong->arena != NULL) {
+			/* song and other strings are freed with the arena */
+			PianoInternRelease (lastSong->artist);
+			PianoInternRelease (lastSong->album);
+			PianoInternRelease (lastSong->stationId);
+			PianoArenaUnref (lastSong->arena);
+			continue;
+		}
+		free (lastSong->audioUrl);
+		free (lastSong->coverArt);
+		free (lastSong->artist);
+		free (lastSong->musicId);
+		free (lastSong->title);
+		free (lastSong->stationId);
+		free (lastSong->album);
+		free (lastSong->feedbackId);
+		free (lastSong->seedId);
+		free (lastSong->detailUrl);
+		free (lastSong->trackToken);
 		free (lastSong);
 	}
 }
@@ -164,6 +177,19 @@ static void PianoDestroyGenres (PianoGenre_t *genres) {
 	}
 }
 
+/*	free genre categories and their genres
+ */
+void PianoDestroyGenreStations (PianoGenreCategory_t *categories) {
+	PianoGenreCategory_t *curGenreCat = categories, *lastGenreCat;
+	while (curGenreCat != NULL) {
+		PianoDestroyGenres (curGenreCat->genres);
+		free (curGenreCat->name);
+		lastGenreCat = curGenreCat;
+		curGenreCat = (PianoGenreCategory_t *) curGenreCat->head.next;
+		free (lastGenreCat);
+	}
+}
+
 /*	destroy user information
  */
 void PianoDestroyUserInfo (PianoUserInfo_t *user) {
@@ -190,41 +216,200 @@ static void PianoDestroyPartner (PianoPartner_t *partner) {
 void PianoDestroy (PianoHandle_t *ph) {
 	PianoDestroyUserInfo (&ph->user);
 	PianoDestroyStations (ph->stations);
+	free (ph->stationIndex.slots);
 	PianoDestroyPartner (&ph->partner);
-	/* destroy genre stations */
-	PianoGenreCategory_t *curGenreCat = ph->genreStations, *lastGenreCat;
-	while (curGenreCat != NULL) {
-		PianoDestroyGenres (curGenreCat->genres);
-		free (curGenreCat->name);
-		lastGenreCat = curGenreCat;
-		curGenreCat = (PianoGenreCategory_t *) curGenreCat->head.next;
-		free (lastGenreCat);
-	}
+	free (ph->stationsChecksum);
+	PianoDestroyGenreStations (ph->genreStations);
+	PianoInternDestroy (ph);
 	memset (ph, 0, sizeof (*ph));
 }
 
-/*	destroy request, free post data. req->responseData is *not* freed here, as
- *	it might be allocated by something else than malloc!
+/*	destroy request, free post data and parser state. req->responseData is
+ *	*not* freed here, as it might be allocated by something else than malloc!
  *	@param piano request
  */
 void PianoDestroyRequest (PianoRequest_t *req) {
 	free (req->postData);
+	if (req->tokener != NULL) {
+		json_tokener_free (req->tokener);
+	}
+	if (req->responseJson != NULL) {
+		json_object_put (req->responseJson);
+	}
 	memset (req, 0, sizeof (*req));
 }
 
-/*	get station from list by id
- *	@param search here
+/*	FNV-1a hash of station id
+ */
+static size_t PianoStationHash (const char *id) {
+	uint32_t h = 2166136261u;
+	for (; *id != '\0'; id++) {
+		h = (h ^ (unsigned char) *id) * 16777619u;
+	}
+	return h;
+}
+
+/*	drop the index, lookups fall back to scanning the list
+ */
+static void PianoStationIndexInvalidate (PianoStationIndex_t *index) {
+	free (index->slots);
+	memset (index, 0, sizeof (*index));
+}
+
+/*	insert into table without resizing, table must have a free slot
+ */
+static void PianoStationIndexInsert (PianoStationIndex_t *index,
+		PianoStation_t *station) {
+	size_t i = PianoStationHash (station->id) & (index->size - 1);
+	while (index->slots[i] != NULL) {
+		if (index->slots[i] == station) {
+			return;
+		}
+		i = (i + 1) & (index->size - 1);
+	}
+	index->slots[i] = station;
+	++index->count;
+}
+
+/*	resize table to hold at least n stations at a load factor of 1/2
+ *	@return false if out of memory
+ */
+static bool PianoStationIndexResize (PianoStationIndex_t *index,
+		const size_t n) {
+	size_t size = 16;
+	while (size < n * 2) {
+		size *= 2;
+	}
+	if (size == index->size) {
+		return true;
+	}
+
+	PianoStation_t **slots = calloc (size, sizeof (*slots));
+	if (slots == NULL) {
+		return false;
+	}
+	PianoStation_t **oldSlots = index->slots;
+	const size_t oldSize = index->size;
+	index->slots = slots;
+	index->size = size;
+	index->count = 0;
+	for (size_t i = 0; i < oldSize; i++) {
+		if (oldSlots[i] != NULL) {
+			PianoStationIndexInsert (index, oldSlots[i]);
+		}
+	}
+	free (oldSlots);
+	return true;
+}
+
+/*	add station to index
+ *	@param piano handle
+ *	@param station, must be in ph->stations already
+ */
+void PianoStationIndexAdd (PianoHandle_t *ph, PianoStation_t *station) {
+	PianoStationIndex_t * const index = &ph->stationIndex;
+
+	if (station->id == NULL) {
+		return;
+	}
+	if (index->size == 0) {
+		/* never built or given up, start over */
+		PianoIndexStations (ph);
+		return;
+	}
+	if ((index->count + 1) * 2 > index->size &&
+			!PianoStationIndexResize (index, index->count + 1)) {
+		PianoStationIndexInvalidate (index);
+		return;
+	}
+	PianoStationIndexInsert (index, station);
+}
+
+/*	remove station from index, before it is unlinked or freed
+ *	@param piano handle
+ *	@param station
+ */
+void PianoStationIndexRemove (PianoHandle_t *ph,
+		const PianoStation_t *station) {
+	PianoStationIndex_t * const index = &ph->stationIndex;
+
+	if (index->size == 0 || station->id == NULL) {
+		return;
+	}
+
+	const size_t mask = index->size - 1;
+	size_t i = PianoStationHash (station->id) & mask;
+	while (index->slots[i] != station) {
+		if (index->slots[i] == NULL) {
+			return;
+		}
+		i = (i + 1) & mask;
+	}
+
+	/* shift following entries back, so probing does not stop early */
+	for (size_t j = (i + 1) & mask; index->slots[j] != NULL;
+			j = (j + 1) & mask) {
+		const size_t home = PianoStationHash (index->slots[j]->id) & mask;
+		/* entry can stay unless its home slot is cyclically in (i, j] */
+		const bool stays = i < j ? (i < home && home <= j) :
+				(i < home || home <= j);
+		if (!stays) {
+			index->slots[i] = index->slots[j];
+			i = j;
+		}
+	}
+	index->slots[i] = NULL;
+	--index->count;
+}
+
+/*	rebuild station index from ph->stations. libpiano keeps it up to date,
+ *	clients must call this after replacing ph->stations themselves.
+ *	@param piano handle
+ */
+void PianoIndexStations (PianoHandle_t *ph) {
+	PianoStationIndex_t * const index = &ph->stationIndex;
+
+	PianoStationIndexInvalidate (index);
+	if (!PianoStationIndexResize (index, ph->stations == NULL ? 0 :
+			PianoListCountP (ph->stations))) {
+		return;
+	}
+	PianoStation_t *curStation = ph->stations;
+	PianoListForeachP (curStation) {
+		if (curStation->id != NULL) {
+			PianoStationIndexInsert (index, curStation);
+		}
+	}
+}
+
+/*	get station by id
+ *	@param piano handle
  *	@param search for this
  *	@return the first station structure matching the given id
  */
-PianoStation_t *PianoFindStationById (PianoStation_t * const stations,
+PianoStation_t *PianoFindStationById (const PianoHandle_t * const ph,
 		const char * const searchStation) {
+	const PianoStationIndex_t * const index = &ph->stationIndex;
+
 	assert (searchStation != NULL);
 
-	PianoStation_t *currStation = stations;
-	PianoListForeachP (currStation) {
-		if (strcmp (currStation->id, searchStation) == 0) {
-			return currStation;
+	if (index->size == 0) {
+		/* out of memory earlier */
+		PianoStation_t *currStation = ph->stations;
+		PianoListForeachP (currStation) {
+			if (currStation->id != NULL &&
+					strcmp (currStation->id, searchStation) == 0) {
+				return currStation;
+			}
+		}
+		return NULL;
+	}
+
+	const size_t mask = index->size - 1;
+	for (size_t i = PianoStationHash (searchStation) & mask;
+			index->slots[i] != NULL; i = (i + 1) & mask) {
+		if (strcmp (index->slots[i]->id, searchStation) == 0) {
+			return index->slots[i];
 		}
 	}
 
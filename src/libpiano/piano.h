@@ -26,6 +26,7 @@ THE SOFTWARE.
 #include "../config.h"
 
 #include <stdbool.h>
+#include <time.h>
 #ifdef __FreeBSD__
 #define _GCRYPT_IN_LIBGCRYPT
 #endif
@@ -50,6 +51,8 @@ typedef struct PianoListHead {
 typedef struct PianoUserInfo {
 	char *listenerId;
 	char *authToken;
+	/* when authToken was issued, tokens expire eventually */
+	time_t authTime;
 } PianoUserInfo_t;
 
 typedef struct PianoStation {
@@ -82,8 +85,15 @@ typedef enum {
 	PIANO_AQ_HIGH = 3,
 } PianoAudioQuality_t;
 
+struct PianoArena;
+struct PianoInternTable;
+
 typedef struct PianoSong {
 	PianoListHead_t head;
+	/* song and its strings belong to this arena if not NULL, see
+	 * PianoDestroyPlaylist. artist, album and stationId are interned
+	 * then, equal strings share storage. */
+	struct PianoArena *arena;
 	char *artist;
 	char *stationId;
 	char *album;
@@ -104,6 +114,8 @@ typedef struct PianoSong {
 /* currently only used for search results */
 typedef struct PianoArtist {
 	PianoListHead_t head;
+	/* like PianoSong_t */
+	struct PianoArena *arena;
 	char *name;
 	char *musicId;
 	char *seedId;
@@ -128,13 +140,26 @@ typedef struct PianoPartner {
 	unsigned int id;
 } PianoPartner_t;
 
+/* hash table of stations by id, open addressing with linear probing */
+typedef struct {
+	PianoStation_t **slots;
+	/* power of two, 0 if the table is unusable */
+	size_t size, count;
+} PianoStationIndex_t;
+
 typedef struct PianoHandle {
 	PianoUserInfo_t user;
 	/* linked lists */
 	PianoStation_t *stations;
+	/* index of stations, see PianoIndexStations */
+	PianoStationIndex_t stationIndex;
 	PianoGenreCategory_t *genreStations;
 	PianoPartner_t partner;
 	int timeOffset;
+	/* checksum of stations, as reported by pandora, may be NULL */
+	char *stationsChecksum;
+	/* strings shared between songs, may outlive the handle */
+	struct PianoInternTable *strings;
 } PianoHandle_t;
 
 typedef struct PianoSearchResult {
@@ -178,8 +203,12 @@ typedef enum {
 	PIANO_REQUEST_DELETE_SEED = 22,
 	PIANO_REQUEST_GET_SETTINGS = 23,
 	PIANO_REQUEST_CHANGE_SETTINGS = 24,
+	PIANO_REQUEST_GET_STATIONS_CHECKSUM = 25,
 } PianoRequestType_t;
 
+struct json_tokener;
+struct json_object;
+
 typedef struct PianoRequest {
 	PianoRequestType_t type;
 	bool secure;
@@ -187,6 +216,10 @@ typedef struct PianoRequest {
 	char urlPath[1024];
 	char *postData;
 	char *responseData;
+	/* response parsed while it is received, see PianoResponseFeed */
+	struct json_tokener *tokener;
+	struct json_object *responseJson;
+	bool responseInvalid;
 } PianoRequest_t;
 
 /* request data structures */
@@ -196,6 +229,22 @@ typedef struct {
 	unsigned char step;
 } PianoRequestDataLogin_t;
 
+/* optional, stations still in use can be removed from ph->stations */
+typedef struct {
+	/* stations that do not exist any more, not freed */
+	PianoStation_t *retRemoved;
+} PianoRequestDataGetStations_t;
+
+/* optional, the result is stored in ph->genreStations otherwise */
+typedef struct {
+	PianoGenreCategory_t *retCategories;
+} PianoRequestDataGetGenreStations_t;
+
+typedef struct {
+	/* station list is out of date */
+	bool retChanged;
+} PianoRequestDataGetStationsChecksum_t;
+
 typedef struct {
 	PianoStation_t *station;
 	PianoAudioQuality_t quality;
@@ -333,6 +382,11 @@ void *PianoListAppend (PianoListHead_t * const l, PianoListHead_t * const e)
 		__attribute__ ((warn_unused_result));
 #define PianoListAppendP(l,e) PianoListAppend(((l) == NULL) ? NULL : &(l)->head, \
 		&(e)->head)
+void *PianoListAppendTail (PianoListHead_t * const l,
+		PianoListHead_t ** const tail, PianoListHead_t * const e)
+		__attribute__ ((warn_unused_result));
+#define PianoListAppendTailP(l,tail,e) PianoListAppendTail( \
+		((l) == NULL) ? NULL : &(l)->head, tail, &(e)->head)
 void *PianoListDelete (PianoListHead_t * const l, PianoListHead_t * const e)
 		__attribute__ ((warn_unused_result));
 #define PianoListDeleteP(l,e) PianoListDelete(((l) == NULL) ? NULL : &(l)->head, \
@@ -354,15 +408,19 @@ void PianoDestroy (PianoHandle_t *);
 void PianoDestroyPlaylist (PianoSong_t *);
 void PianoDestroySearchResult (PianoSearchResult_t *);
 void PianoDestroyStationInfo (PianoStationInfo_t *);
+void PianoDestroyStations (PianoStation_t *);
+void PianoDestroyGenreStations (PianoGenreCategory_t *);
 
 /* pandora rpc */
 PianoReturn_t PianoRequest (PianoHandle_t *, PianoRequest_t *,
 		PianoRequestType_t);
 PianoReturn_t PianoResponse (PianoHandle_t *, PianoRequest_t *);
+void PianoResponseFeed (PianoRequest_t *, const char *, size_t);
 void PianoDestroyRequest (PianoRequest_t *);
 
 /* misc */
-PianoStation_t *PianoFindStationById (PianoStation_t * const,
+PianoStation_t *PianoFindStationById (const PianoHandle_t * const,
 		const char * const);
+void PianoIndexStations (PianoHandle_t *);
 const char *PianoErrorToStr (PianoReturn_t);
 
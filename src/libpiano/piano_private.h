@@ -25,6 +25,22 @@ THE SOFTWARE.
 
 #include "piano.h"
 
+typedef struct PianoArena PianoArena_t;
+typedef struct PianoInternTable PianoInternTable_t;
+
 void PianoDestroyStation (PianoStation_t *station);
 void PianoDestroyUserInfo (PianoUserInfo_t *user);
+void PianoStationIndexAdd (PianoHandle_t *ph, PianoStation_t *station);
+void PianoStationIndexRemove (PianoHandle_t *ph,
+		const PianoStation_t *station);
+
+PianoArena_t *PianoArenaNew (void);
+void *PianoArenaAlloc (PianoArena_t *arena, size_t size);
+char *PianoArenaStrdup (PianoArena_t *arena, const char *s);
+void PianoArenaRef (PianoArena_t *arena);
+void PianoArenaUnref (PianoArena_t *arena);
+
+char *PianoIntern (PianoHandle_t *ph, const char *s);
+void PianoInternRelease (char *s);
+void PianoInternDestroy (PianoHandle_t *ph);
 
@@ -120,6 +120,14 @@ PianoReturn_t PianoRequest (PianoHandle_t *ph, PianoRequest_t *req,
 			break;
 		}
 
+		case PIANO_REQUEST_GET_STATIONS_CHECKSUM: {
+			/* has the station list changed since the last GET_STATIONS? */
+			assert (ph->user.listenerId != NULL);
+			assert (req->data != NULL);
+			method = "user.getStationListChecksum";
+			break;
+		}
+
 		case PIANO_REQUEST_GET_PLAYLIST: {
 			/* get playlist for specified station */
 			PianoRequestDataGetPlaylist_t *reqData = req->data;
@@ -24,6 +24,7 @@ THE SOFTWARE.
 #include "../config.h"
 
 #include <json.h>
+#include <limits.h>
 #include <string.h>
 #include <assert.h>
 #include <time.h>
@@ -45,6 +46,37 @@ static char *PianoJsonStrdup (json_object *j, const char *key) {
 	}
 }
 
+/*	like PianoJsonStrdup, but copy into arena
+ */
+static char *PianoJsonArenaStrdup (PianoArena_t *arena, json_object *j,
+		const char *key) {
+	assert (arena != NULL);
+	assert (j != NULL);
+	assert (key != NULL);
+
+	json_object *v;
+	if (json_object_object_get_ex (j, key, &v)) {
+		return PianoArenaStrdup (arena, json_object_get_string (v));
+	} else {
+		return NULL;
+	}
+}
+
+/*	like PianoJsonStrdup, but return shared copy, see PianoIntern
+ */
+static char *PianoJsonIntern (PianoHandle_t *ph, json_object *j,
+		const char *key) {
+	assert (j != NULL);
+	assert (key != NULL);
+
+	json_object *v;
+	if (json_object_object_get_ex (j, key, &v)) {
+		return PianoIntern (ph, json_object_get_string (v));
+	} else {
+		return NULL;
+	}
+}
+
 static bool getBoolDefault (json_object * const j, const char * const key, const bool def) {
 	assert (j != NULL);
 	assert (key != NULL);
@@ -88,10 +120,50 @@ static void PianoStrpcat (char * restrict dest, const char * restrict src,
 	*dest = '\0';
 }
 
+/*	parse response chunk by chunk while it is received, instead of
+ *	collecting it in responseData first
+ *	@param initialized request
+ *	@param chunk
+ *	@param chunk size
+ */
+void PianoResponseFeed (PianoRequest_t * const req, const char * const data,
+		const size_t size) {
+	assert (req != NULL);
+	assert (data != NULL);
+
+	if (req->responseJson != NULL || req->responseInvalid) {
+		/* trailing data or garbage */
+		return;
+	}
+
+	if (req->tokener == NULL &&
+			(req->tokener = json_tokener_new ()) == NULL) {
+		req->responseInvalid = true;
+		return;
+	}
+
+	size_t pos = 0;
+	while (pos < size) {
+		/* the tokener counts in int */
+		const int len = size - pos > INT_MAX ? INT_MAX : (int) (size - pos);
+		json_object * const j = json_tokener_parse_ex (req->tokener,
+				&data[pos], len);
+		if (j != NULL) {
+			req->responseJson = j;
+			break;
+		} else if (json_tokener_get_error (req->tokener) !=
+				json_tokener_continue) {
+			req->responseInvalid = true;
+			break;
+		}
+		pos += len;
+	}
+}
+
 /*	parse xml response and update data structures/return new data structure
  *	@param piano handle
  *	@param initialized request (expects responseData to be a NUL-terminated
- *			string)
+ *			string or the response to be fed to PianoResponseFeed)
  */
 PianoReturn_t PianoResponse (PianoHandle_t *ph, PianoRequest_t *req) {
 	PianoReturn_t ret = PIANO_RET_OK;
@@ -99,10 +171,17 @@ PianoReturn_t PianoResponse (PianoHandle_t *ph, PianoRequest_t *req) {
 	assert (ph != NULL);
 	assert (req != NULL);
 
-	json_object * const j = json_tokener_parse (req->responseData);
+	json_object *j = NULL;
+	if (req->responseJson != NULL) {
+		/* we own it now */
+		j = req->responseJson;
+		req->responseJson = NULL;
+	} else if (req->responseData != NULL) {
+		j = json_tokener_parse (req->responseData);
+	}
 
 	json_object *status;
-	if (!json_object_object_get_ex (j, "stat", &status)) {
+	if (j == NULL || !json_object_object_get_ex (j, "stat", &status)) {
 		ret = PIANO_RET_INVALID_RESPONSE;
 		goto cleanup;
 	}
@@ -139,7 +218,6 @@ PianoReturn_t PianoResponse (PianoHandle_t *ph, PianoRequest_t *req) {
 			/* authenticate user */
 			PianoRequestDataLogin_t *reqData = req->data;
 
-			assert (req->responseData != NULL);
 			assert (reqData != NULL);
 
 			switch (reqData->step) {
@@ -169,7 +247,9 @@ PianoReturn_t PianoResponse (PianoHandle_t *ph, PianoRequest_t *req) {
 						ret = PIANO_RET_CONTINUE_REQUEST;
 					}
 					free (decryptedTimestamp);
-					/* get auth token */
+					/* get auth token, replacing the old one when
+					 * reauthenticating */
+					free (ph->partner.authToken);
 					ph->partner.authToken = PianoJsonStrdup (result,
 							"partnerAuthToken");
 					json_object *partnerId;
@@ -191,23 +271,26 @@ PianoReturn_t PianoResponse (PianoHandle_t *ph, PianoRequest_t *req) {
 					ph->user.listenerId = PianoJsonStrdup (result, "userId");
 					ph->user.authToken = PianoJsonStrdup (result,
 							"userAuthToken");
+					ph->user.authTime = time (NULL);
 					break;
 			}
 			break;
 		}
 
 		case PIANO_REQUEST_GET_STATIONS: {
-			/* get stations */
-			assert (req->responseData != NULL);
-
-			json_object *stations, *mix = NULL;
+			/* get stations, existing ones are updated in place, so pointers
+			 * to them stay valid */
+			PianoRequestDataGetStations_t *reqData = req->data;
+			json_object *stations, *mix = NULL, *checksum;
+			PianoStation_t *updated = NULL;
+			PianoListHead_t *updatedTail = NULL;
 
 			if (!json_object_object_get_ex (result, "stations", &stations)) {
 				break;
 			}
 
 			for (int i = 0; i < json_object_array_length (stations); i++) {
-				PianoStation_t *tmpStation;
+				PianoStation_t *tmpStation, *oldStation;
 				json_object *s = json_object_array_get_idx (stations, i);
 
 				if ((tmpStation = calloc (1, sizeof (*tmpStation))) == NULL) {
@@ -221,9 +304,36 @@ PianoReturn_t PianoResponse (PianoHandle_t *ph, PianoRequest_t *req) {
 					json_object_object_get_ex (s, "quickMixStationIds", &mix);
 				}
 
+				oldStation = tmpStation->id == NULL ? NULL :
+						PianoFindStationById (ph, tmpStation->id);
+				if (oldStation != NULL) {
+					/* ids may repeat, do not find it twice */
+					PianoStationIndexRemove (ph, oldStation);
+					ph->stations = PianoListDeleteP (ph->stations, oldStation);
+					oldStation->head.next = NULL;
+					free (oldStation->name);
+					oldStation->name = tmpStation->name;
+					oldStation->isCreator = tmpStation->isCreator;
+					oldStation->isQuickMix = tmpStation->isQuickMix;
+					oldStation->useQuickMix = false;
+					free (tmpStation->id);
+					free (tmpStation);
+					tmpStation = oldStation;
+				}
+
 				/* start new linked list or append */
-				ph->stations = PianoListAppendP (ph->stations, tmpStation);
+				updated = PianoListAppendTailP (updated, &updatedTail,
+						tmpStation);
+			}
+
+			/* whatever is left was removed */
+			if (reqData != NULL) {
+				reqData->retRemoved = ph->stations;
+			} else {
+				PianoDestroyStations (ph->stations);
 			}
+			ph->stations = updated;
+			PianoIndexStations (ph);
 
 			/* fix quickmix flags */
 			if (mix != NULL) {
@@ -238,6 +348,25 @@ PianoReturn_t PianoResponse (PianoHandle_t *ph, PianoRequest_t *req) {
 					}
 				}
 			}
+
+			if (json_object_object_get_ex (result, "checksum", &checksum)) {
+				free (ph->stationsChecksum);
+				ph->stationsChecksum = strdup (
+						json_object_get_string (checksum));
+			}
+			break;
+		}
+
+		case PIANO_REQUEST_GET_STATIONS_CHECKSUM: {
+			PianoRequestDataGetStationsChecksum_t *reqData = req->data;
+			json_object *checksum;
+
+			assert (reqData != NULL);
+
+			reqData->retChanged = !json_object_object_get_ex (result,
+					"checksum", &checksum) || ph->stationsChecksum == NULL ||
+					strcmp (json_object_get_string (checksum),
+					ph->stationsChecksum) != 0;
 			break;
 		}
 
@@ -245,8 +374,8 @@ PianoReturn_t PianoResponse (PianoHandle_t *ph, PianoRequest_t *req) {
 			/* get playlist, usually four songs */
 			PianoRequestDataGetPlaylist_t *reqData = req->data;
 			PianoSong_t *playlist = NULL;
+			PianoListHead_t *tail = NULL;
 
-			assert (req->responseData != NULL);
 			assert (reqData != NULL);
 			assert (reqData->quality != PIANO_AQ_UNKNOWN);
 
@@ -256,19 +385,28 @@ PianoReturn_t PianoResponse (PianoHandle_t *ph, PianoRequest_t *req) {
 			}
 			assert (items != NULL);
 
+			/* all songs and their strings share one allocation */
+			PianoArena_t *arena = PianoArenaNew ();
+			if (arena == NULL) {
+				ret = PIANO_RET_OUT_OF_MEMORY;
+				goto cleanup;
+			}
+
 			for (int i = 0; i < json_object_array_length (items); i++) {
 				json_object *s = json_object_array_get_idx (items, i);
 				PianoSong_t *song;
 
-				if ((song = calloc (1, sizeof (*song))) == NULL) {
-					return PIANO_RET_OUT_OF_MEMORY;
-				}
-
 				if (!json_object_object_get_ex (s, "artistName", NULL)) {
-					free (song);
 					continue;
 				}
 
+				if ((song = PianoArenaAlloc (arena, sizeof (*song))) == NULL) {
+					ret = PIANO_RET_OUT_OF_MEMORY;
+					PianoDestroyPlaylist (playlist);
+					PianoArenaUnref (arena);
+					goto cleanup;
+				}
+
 				/* get audio url based on selected quality */
 				static const char *qualityMap[] = {"", "lowQuality", "mediumQuality",
 						"highQuality"};
@@ -290,24 +428,26 @@ PianoReturn_t PianoResponse (PianoHandle_t *ph, PianoRequest_t *req) {
 								break;
 							}
 						}
-						song->audioUrl = PianoJsonStrdup (qmap, "audioUrl");
+						song->audioUrl = PianoJsonArenaStrdup (arena, qmap,
+								"audioUrl");
 					} else {
 						/* requested quality is not available */
 						ret = PIANO_RET_QUALITY_UNAVAILABLE;
-						free (song);
 						PianoDestroyPlaylist (playlist);
+						PianoArenaUnref (arena);
 						goto cleanup;
 					}
 				}
 
 				json_object *v;
-				song->artist = PianoJsonStrdup (s, "artistName");
-				song->album = PianoJsonStrdup (s, "albumName");
-				song->title = PianoJsonStrdup (s, "songName");
-				song->trackToken = PianoJsonStrdup (s, "trackToken");
-				song->stationId = PianoJsonStrdup (s, "stationId");
-				song->coverArt = PianoJsonStrdup (s, "albumArtUrl");
-				song->detailUrl = PianoJsonStrdup (s, "songDetailUrl");
+				song->artist = PianoJsonIntern (ph, s, "artistName");
+				song->album = PianoJsonIntern (ph, s, "albumName");
+				song->title = PianoJsonArenaStrdup (arena, s, "songName");
+				song->trackToken = PianoJsonArenaStrdup (arena, s, "trackToken");
+				song->stationId = PianoJsonIntern (ph, s, "stationId");
+				song->coverArt = PianoJsonArenaStrdup (arena, s, "albumArtUrl");
+				song->detailUrl = PianoJsonArenaStrdup (arena, s,
+						"songDetailUrl");
 				song->fileGain = json_object_object_get_ex (s, "trackGain", &v) ?
 						json_object_get_double (v) : 0.0;
 				song->length = json_object_object_get_ex (s, "trackLength", &v) ?
@@ -319,8 +459,12 @@ PianoReturn_t PianoResponse (PianoHandle_t *ph, PianoRequest_t *req) {
 						break;
 				}
 
-				playlist = PianoListAppendP (playlist, song);
+				song->arena = arena;
+				PianoArenaRef (arena);
+				playlist = PianoListAppendTailP (playlist, &tail, song);
 			}
+			/* freed once the last song is gone */
+			PianoArenaUnref (arena);
 
 			reqData->retPlaylist = playlist;
 			break;
@@ -357,6 +501,7 @@ PianoReturn_t PianoResponse (PianoHandle_t *ph, PianoRequest_t *req) {
 
 			assert (station != NULL);
 
+			PianoStationIndexRemove (ph, station);
 			ph->stations = PianoListDeleteP (ph->stations, station);
 			PianoDestroyStation (station);
 			free (station);
@@ -368,50 +513,74 @@ PianoReturn_t PianoResponse (PianoHandle_t *ph, PianoRequest_t *req) {
 			PianoRequestDataSearch_t *reqData = req->data;
 			PianoSearchResult_t *searchResult;
 
-			assert (req->responseData != NULL);
 			assert (reqData != NULL);
 
 			searchResult = &reqData->searchResult;
 			memset (searchResult, 0, sizeof (*searchResult));
 
+			PianoArena_t *arena = PianoArenaNew ();
+			if (arena == NULL) {
+				ret = PIANO_RET_OUT_OF_MEMORY;
+				goto cleanup;
+			}
+
 			/* get artists */
 			json_object *artists;
+			PianoListHead_t *tail = NULL;
 			if (json_object_object_get_ex (result, "artists", &artists)) {
 				for (int i = 0; i < json_object_array_length (artists); i++) {
 					json_object *a = json_object_array_get_idx (artists, i);
 					PianoArtist_t *artist;
 
-					if ((artist = calloc (1, sizeof (*artist))) == NULL) {
-						return PIANO_RET_OUT_OF_MEMORY;
+					if ((artist = PianoArenaAlloc (arena,
+							sizeof (*artist))) == NULL) {
+						ret = PIANO_RET_OUT_OF_MEMORY;
+						break;
 					}
 
-					artist->name = PianoJsonStrdup (a, "artistName");
-					artist->musicId = PianoJsonStrdup (a, "musicToken");
+					artist->arena = arena;
+					PianoArenaRef (arena);
+					artist->name = PianoJsonArenaStrdup (arena, a, "artistName");
+					artist->musicId = PianoJsonArenaStrdup (arena, a,
+							"musicToken");
 
-					searchResult->artists =
-							PianoListAppendP (searchResult->artists, artist);
+					searchResult->artists = PianoListAppendTailP (
+							searchResult->artists, &tail, artist);
 				}
 			}
 
 			/* get songs */
 			json_object *songs;
-			if (json_object_object_get_ex (result, "songs", &songs)) {
+			tail = NULL;
+			if (ret == PIANO_RET_OK &&
+					json_object_object_get_ex (result, "songs", &songs)) {
 				for (int i = 0; i < json_object_array_length (songs); i++) {
 					json_object *s = json_object_array_get_idx (songs, i);
 					PianoSong_t *song;
 
-					if ((song = calloc (1, sizeof (*song))) == NULL) {
-						return PIANO_RET_OUT_OF_MEMORY;
+					if ((song = PianoArenaAlloc (arena,
+							sizeof (*song))) == NULL) {
+						ret = PIANO_RET_OUT_OF_MEMORY;
+						break;
 					}
 
-					song->title = PianoJsonStrdup (s, "songName");
-					song->artist = PianoJsonStrdup (s, "artistName");
-					song->musicId = PianoJsonStrdup (s, "musicToken");
+					song->arena = arena;
+					PianoArenaRef (arena);
+					song->title = PianoJsonArenaStrdup (arena, s, "songName");
+					song->artist = PianoJsonIntern (ph, s, "artistName");
+					song->musicId = PianoJsonArenaStrdup (arena, s,
+							"musicToken");
 
-					searchResult->songs =
-							PianoListAppendP (searchResult->songs, song);
+					searchResult->songs = PianoListAppendTailP (
+							searchResult->songs, &tail, song);
 				}
 			}
+
+			PianoArenaUnref (arena);
+			if (ret != PIANO_RET_OK) {
+				PianoDestroySearchResult (searchResult);
+				memset (searchResult, 0, sizeof (*searchResult));
+			}
 			break;
 		}
 
@@ -425,14 +594,16 @@ PianoReturn_t PianoResponse (PianoHandle_t *ph, PianoRequest_t *req) {
 
 			PianoJsonParseStation (result, tmpStation);
 
-			PianoStation_t *search = PianoFindStationById (ph->stations,
-					tmpStation->id);
+			PianoStation_t *search = tmpStation->id == NULL ? NULL :
+					PianoFindStationById (ph, tmpStation->id);
 			if (search != NULL) {
+				PianoStationIndexRemove (ph, search);
 				ph->stations = PianoListDeleteP (ph->stations, search);
 				PianoDestroyStation (search);
 				free (search);
 			}
 			ph->stations = PianoListAppendP (ph->stations, tmpStation);
+			PianoStationIndexAdd (ph, tmpStation);
 			break;
 		}
 
@@ -448,8 +619,12 @@ PianoReturn_t PianoResponse (PianoHandle_t *ph, PianoRequest_t *req) {
 			break;
 
 		case PIANO_REQUEST_GET_GENRE_STATIONS: {
-			/* get genre stations */
+			/* get genre stations, into request data if given */
+			PianoRequestDataGetGenreStations_t *reqData = req->data;
+			PianoGenreCategory_t **genreStations = reqData != NULL ?
+					&reqData->retCategories : &ph->genreStations;
 			json_object *categories;
+			PianoListHead_t *catTail = NULL;
 			if (json_object_object_get_ex (result, "categories", &categories)) {
 				for (int i = 0; i < json_object_array_length (categories); i++) {
 					json_object *c = json_object_array_get_idx (categories, i);
@@ -465,6 +640,7 @@ PianoReturn_t PianoResponse (PianoHandle_t *ph, PianoRequest_t *req) {
 
 					/* get genre subnodes */
 					json_object *stations;
+					PianoListHead_t *genreTail = NULL;
 					if (json_object_object_get_ex (c, "stations", &stations)) {
 						for (int k = 0;
 								k < json_object_array_length (stations); k++) {
@@ -483,14 +659,14 @@ PianoReturn_t PianoResponse (PianoHandle_t *ph, PianoRequest_t *req) {
 							tmpGenre->musicId = PianoJsonStrdup (s,
 									"stationToken");
 
-							tmpGenreCategory->genres =
-									PianoListAppendP (tmpGenreCategory->genres,
+							tmpGenreCategory->genres = PianoListAppendTailP (
+									tmpGenreCategory->genres, &genreTail,
 									tmpGenre);
 						}
 					}
 
-					ph->genreStations = PianoListAppendP (ph->genreStations,
-							tmpGenreCategory);
+					*genreStations = PianoListAppendTailP (*genreStations,
+							&catTail, tmpGenreCategory);
 				}
 			}
 			break;
@@ -500,7 +676,6 @@ PianoReturn_t PianoResponse (PianoHandle_t *ph, PianoRequest_t *req) {
 			/* transform shared station into private and update isCreator flag */
 			PianoStation_t *station = req->data;
 
-			assert (req->responseData != NULL);
 			assert (station != NULL);
 
 			station->isCreator = 1;
@@ -567,6 +742,7 @@ PianoReturn_t PianoResponse (PianoHandle_t *ph, PianoRequest_t *req) {
 			if (json_object_object_get_ex (result, "music", &music)) {
 				/* songs */
 				json_object *songs;
+				PianoListHead_t *tail = NULL;
 				if (json_object_object_get_ex (music, "songs", &songs)) {
 					for (int i = 0; i < json_object_array_length (songs); i++) {
 						json_object *s = json_object_array_get_idx (songs, i);
@@ -581,13 +757,14 @@ PianoReturn_t PianoResponse (PianoHandle_t *ph, PianoRequest_t *req) {
 						seedSong->artist = PianoJsonStrdup (s, "artistName");
 						seedSong->seedId = PianoJsonStrdup (s, "seedId");
 
-						info->songSeeds = PianoListAppendP (info->songSeeds,
-								seedSong);
+						info->songSeeds = PianoListAppendTailP (
+								info->songSeeds, &tail, seedSong);
 					}
 				}
 
 				/* artists */
 				json_object *artists;
+				tail = NULL;
 				if (json_object_object_get_ex (music, "artists", &artists)) {
 					for (int i = 0; i < json_object_array_length (artists); i++) {
 						json_object *a = json_object_array_get_idx (artists, i);
@@ -601,8 +778,8 @@ PianoReturn_t PianoResponse (PianoHandle_t *ph, PianoRequest_t *req) {
 						seedArtist->name = PianoJsonStrdup (a, "artistName");
 						seedArtist->seedId = PianoJsonStrdup (a, "seedId");
 
-						info->artistSeeds =
-								PianoListAppendP (info->artistSeeds, seedArtist);
+						info->artistSeeds = PianoListAppendTailP (
+								info->artistSeeds, &tail, seedArtist);
 					}
 				}
 			}
@@ -611,6 +788,8 @@ PianoReturn_t PianoResponse (PianoHandle_t *ph, PianoRequest_t *req) {
 			json_object *feedback;
 			if (json_object_object_get_ex (result, "feedback", &feedback)) {
 				static const char * const keys[] = {"thumbsUp", "thumbsDown"};
+				/* both go into the same list */
+				PianoListHead_t *tail = NULL;
 				for (size_t i = 0; i < sizeof (keys)/sizeof (*keys); i++) {
 					json_object *val;
 					if (!json_object_object_get_ex (feedback, keys[i], &val)) {
@@ -634,8 +813,8 @@ PianoReturn_t PianoResponse (PianoHandle_t *ph, PianoRequest_t *req) {
 						feedbackSong->rating = getBoolDefault (s, "isPositive",
 								false) ?  PIANO_RATE_LOVE : PIANO_RATE_BAN;
 
-						info->feedback = PianoListAppendP (info->feedback,
-								feedbackSong);
+						info->feedback = PianoListAppendTailP (info->feedback,
+								&tail, feedbackSong);
 					}
 				}
 			}
@@ -0,0 +1,426 @@
+/*
+Copyright (c) 2026
+        pianobar contributors
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+
+/* EBU R128 / ITU-R BS.1770 integrated loudness and a persistent cache of
+ * measured values */
+
+#include "config.h"
+
+#include <assert.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <libavutil/channel_layout.h>
+
+#include "loudness.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+/* gating block energy below -70 LUFS is ignored */
+#define BAR_LOUDNESS_ABSGATE -70.0
+/* relative gate, in LU below the ungated loudness */
+#define BAR_LOUDNESS_RELGATE -10.0
+
+void BarLoudnessInit(BarLoudness_t *const m) {
+    memset(m, 0, sizeof(*m));
+}
+
+void BarLoudnessDestroy(BarLoudness_t *const m) {
+    free(m->blocks);
+    memset(m, 0, sizeof(*m));
+}
+
+/*	K-weighting filter coefficients for arbitrary sample rates, the
+ *	constants are from the 48 kHz filter in BS.1770
+ */
+static void BarLoudnessSetup(BarLoudness_t *const m, const int rate,
+                             const int channels) {
+    m->rate = rate;
+    m->channels = channels;
+    m->subLen = rate / 10;
+
+    /* high shelf */
+    double f0 = 1681.974450955533, q = 0.7071752369554196;
+    double k = tan(M_PI * f0 / rate);
+    const double vh = pow(10.0, 3.999843853973347 / 20.0);
+    const double vb = pow(vh, 0.4996667741545416);
+    double a0 = 1.0 + k / q + k * k;
+    m->shelf.b0 = (vh + vb * k / q + k * k) / a0;
+    m->shelf.b1 = 2.0 * (k * k - vh) / a0;
+    m->shelf.b2 = (vh - vb * k / q + k * k) / a0;
+    m->shelf.a1 = 2.0 * (k * k - 1.0) / a0;
+    m->shelf.a2 = (1.0 - k / q + k * k) / a0;
+
+    /* high pass */
+    f0 = 38.13547087602444;
+    q = 0.5003270373238773;
+    k = tan(M_PI * f0 / rate);
+    a0 = 1.0 + k / q + k * k;
+    m->highpass.b0 = 1.0;
+    m->highpass.b1 = -2.0;
+    m->highpass.b2 = 1.0;
+    m->highpass.a1 = 2.0 * (k * k - 1.0) / a0;
+    m->highpass.a2 = (1.0 - k / q + k * k) / a0;
+}
+
+/*	filter one sample, returns its energy
+ */
+static inline double BarLoudnessWeight(const BarLoudness_t *const m,
+                                       double *const z, const double x) {
+    const BarLoudnessBiquad_t *const s = &m->shelf, *const h = &m->highpass;
+    const double y1 = s->b0 * x + z[0];
+    z[0] = s->b1 * x - s->a1 * y1 + z[1];
+    z[1] = s->b2 * x - s->a2 * y1;
+    const double y2 = h->b0 * y1 + z[2];
+    z[2] = h->b1 * y1 - h->a1 * y2 + z[3];
+    z[3] = h->b2 * y1 - h->a2 * y2;
+    return y2 * y2;
+}
+
+#define weightloop(type, data, stride, scale)                              \
+    do {                                                                   \
+        const type *const p = (const type *)(data);                        \
+        for (size_t i = 0; i < n; i++) {                                   \
+            sum += BarLoudnessWeight(m, z, p[i * (stride)] * (scale));     \
+        }                                                                  \
+    } while (0)
+
+/*	filter n samples of channel c starting at frame offset off
+ *	@return sum of squares
+ */
+static double BarLoudnessChannel(BarLoudness_t *const m, const AVFrame *const f,
+                                 const int c, const size_t off,
+                                 const size_t n) {
+    double *const z = m->z[c];
+    const int ch = m->channels;
+    uint8_t *const *const d = f->extended_data;
+    double sum = 0;
+
+    switch (f->format) {
+        case AV_SAMPLE_FMT_FLTP:
+            weightloop(float, (const float *)d[c] + off, 1, 1.0);
+            break;
+
+        case AV_SAMPLE_FMT_FLT:
+            weightloop(float, (const float *)d[0] + off * ch + c, ch, 1.0);
+            break;
+
+        case AV_SAMPLE_FMT_DBLP:
+            weightloop(double, (const double *)d[c] + off, 1, 1.0);
+            break;
+
+        case AV_SAMPLE_FMT_DBL:
+            weightloop(double, (const double *)d[0] + off * ch + c, ch, 1.0);
+            break;
+
+        case AV_SAMPLE_FMT_S16P:
+            weightloop(int16_t, (const int16_t *)d[c] + off, 1,
+                       1.0 / 32768.0);
+            break;
+
+        case AV_SAMPLE_FMT_S16:
+            weightloop(int16_t, (const int16_t *)d[0] + off * ch + c, ch,
+                       1.0 / 32768.0);
+            break;
+
+        case AV_SAMPLE_FMT_S32P:
+            weightloop(int32_t, (const int32_t *)d[c] + off, 1,
+                       1.0 / 2147483648.0);
+            break;
+
+        case AV_SAMPLE_FMT_S32:
+            weightloop(int32_t, (const int32_t *)d[0] + off * ch + c, ch,
+                       1.0 / 2147483648.0);
+            break;
+
+        default:
+            m->failed = true;
+            break;
+    }
+
+    return sum;
+}
+
+#undef weightloop
+
+/*	a 100 ms sub-block is complete, emit a 400 ms gating block
+ */
+static void BarLoudnessSubBlock(BarLoudness_t *const m) {
+    m->sub[m->subCount % 4] = m->subSum / m->subLen;
+    ++m->subCount;
+    m->subSum = 0;
+    m->subPos = 0;
+
+    if (m->subCount < 4) {
+        return;
+    }
+
+    if (m->blockCount >= m->blockSize) {
+        /* about 600 blocks per minute */
+        m->blockSize = m->blockSize == 0 ? 2048 : m->blockSize * 2;
+        m->blocks = realloc(m->blocks, m->blockSize * sizeof(*m->blocks));
+        assert(m->blocks != NULL);
+    }
+    m->blocks[m->blockCount++] =
+        (m->sub[0] + m->sub[1] + m->sub[2] + m->sub[3]) / 4.0;
+}
+
+/*	feed decoded audio into the meter
+ */
+void BarLoudnessAdd(BarLoudness_t *const m, const AVFrame *const frame) {
+    assert(m != NULL);
+    assert(frame != NULL);
+
+    if (m->failed) {
+        return;
+    }
+
+    const int channels =
+        av_get_channel_layout_nb_channels(frame->channel_layout);
+    if (m->rate == 0) {
+        if (channels <= 0 || channels > BAR_LOUDNESS_MAXCHANNELS ||
+            frame->sample_rate < 10) {
+            m->failed = true;
+            return;
+        }
+        BarLoudnessSetup(m, frame->sample_rate, channels);
+    } else if (m->rate != frame->sample_rate || m->channels != channels) {
+        /* format change mid-song, result would be meaningless */
+        m->failed = true;
+        return;
+    }
+
+    const size_t samples = frame->nb_samples;
+    size_t done = 0;
+    while (done < samples && !m->failed) {
+        const size_t left = m->subLen - m->subPos;
+        const size_t n = samples - done < left ? samples - done : left;
+        /* all channels are weighted equally (no surround content) */
+        for (int c = 0; c < m->channels; c++) {
+            m->subSum += BarLoudnessChannel(m, frame, c, done, n);
+        }
+        m->subPos += n;
+        done += n;
+        if (m->subPos == m->subLen) {
+            BarLoudnessSubBlock(m);
+        }
+    }
+}
+
+/*	gated mean of all blocks louder than threshold
+ */
+static double BarLoudnessGatedMean(const BarLoudness_t *const m,
+                                   const double threshold) {
+    double sum = 0;
+    size_t count = 0;
+    for (size_t i = 0; i < m->blockCount; i++) {
+        if (m->blocks[i] > threshold) {
+            sum += m->blocks[i];
+            ++count;
+        }
+    }
+    return count == 0 ? 0 : sum / count;
+}
+
+static double BarLoudnessToEnergy(const double lufs) {
+    return pow(10.0, (lufs + 0.691) / 10.0);
+}
+
+/*	compute integrated loudness
+ *	@param meter
+ *	@param result in LUFS
+ *	@return false if not enough (valid) audio was seen
+ */
+bool BarLoudnessIntegrated(const BarLoudness_t *const m, float *const ret) {
+    assert(m != NULL);
+    assert(ret != NULL);
+
+    if (m->failed || m->blockCount == 0) {
+        return false;
+    }
+
+    const double absGate = BarLoudnessToEnergy(BAR_LOUDNESS_ABSGATE);
+    const double ungated = BarLoudnessGatedMean(m, absGate);
+    if (ungated <= 0) {
+        /* silence */
+        return false;
+    }
+    double relGate = ungated * pow(10.0, BAR_LOUDNESS_RELGATE / 10.0);
+    if (relGate < absGate) {
+        relGate = absGate;
+    }
+    const double gated = BarLoudnessGatedMean(m, relGate);
+    if (gated <= 0) {
+        return false;
+    }
+
+    *ret = -0.691 + 10.0 * log10(gated);
+    return true;
+}
+
+static int BarLoudnessEntryCmp(const void *a, const void *b) {
+    const BarLoudnessEntry_t *const ea = a, *const eb = b;
+    return strcmp(ea->musicId, eb->musicId);
+}
+
+/*	find position of musicId (or where it would be inserted)
+ */
+static size_t BarLoudnessDbFind(const BarLoudnessDb_t *const db,
+                                const char *const musicId, bool *const found) {
+    size_t lo = 0, hi = db->count;
+    *found = false;
+    while (lo < hi) {
+        const size_t mid = lo + (hi - lo) / 2;
+        const int cmp = strcmp(db->entry[mid].musicId, musicId);
+        if (cmp == 0) {
+            *found = true;
+            return mid;
+        } else if (cmp < 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+static void BarLoudnessDbGrow(BarLoudnessDb_t *const db) {
+    if (db->count >= db->size) {
+        db->size = db->size == 0 ? 256 : db->size * 2;
+        db->entry = realloc(db->entry, db->size * sizeof(*db->entry));
+        assert(db->entry != NULL);
+    }
+}
+
+/*	read loudness cache. The file contains one "musicId loudness" pair per
+ *	line and is only ever appended to.
+ *	@param database
+ *	@param path
+ */
+void BarLoudnessDbLoad(BarLoudnessDb_t *const db, const char *const path) {
+    assert(db != NULL);
+    assert(path != NULL);
+
+    memset(db, 0, sizeof(*db));
+    db->path = strdup(path);
+
+    FILE *const fp = fopen(path, "r");
+    if (fp == NULL) {
+        return;
+    }
+
+    char line[256], musicId[128];
+    int whole, frac;
+    while (fgets(line, sizeof(line), fp) != NULL) {
+        /* written as fixed point, independent of LC_NUMERIC */
+        if (sscanf(line, "%127s %d.%2d", musicId, &whole, &frac) != 3) {
+            continue;
+        }
+        BarLoudnessDbGrow(db);
+        BarLoudnessEntry_t *const e = &db->entry[db->count++];
+        e->musicId = strdup(musicId);
+        e->loudness = whole - frac / 100.0f;
+    }
+    fclose(fp);
+
+    qsort(db->entry, db->count, sizeof(*db->entry), BarLoudnessEntryCmp);
+
+    /* remove duplicates */
+    size_t j = 0;
+    for (size_t i = 0; i < db->count; i++) {
+        if (j > 0 &&
+            strcmp(db->entry[j - 1].musicId, db->entry[i].musicId) == 0) {
+            free(db->entry[i].musicId);
+            continue;
+        }
+        db->entry[j++] = db->entry[i];
+    }
+    db->count = j;
+}
+
+void BarLoudnessDbDestroy(BarLoudnessDb_t *const db) {
+    for (size_t i = 0; i < db->count; i++) {
+        free(db->entry[i].musicId);
+    }
+    free(db->entry);
+    free(db->path);
+    memset(db, 0, sizeof(*db));
+}
+
+/*	look up measured loudness
+ *	@return true if found
+ */
+bool BarLoudnessDbGet(const BarLoudnessDb_t *const db,
+                      const char *const musicId, float *const ret) {
+    assert(db != NULL);
+
+    if (musicId == NULL || db->count == 0) {
+        return false;
+    }
+
+    bool found;
+    const size_t i = BarLoudnessDbFind(db, musicId, &found);
+    if (found) {
+        *ret = db->entry[i].loudness;
+    }
+    return found;
+}
+
+/*	add measurement and append it to the cache file
+ */
+void BarLoudnessDbPut(BarLoudnessDb_t *const db, const char *const musicId,
+                      const float loudness) {
+    assert(db != NULL);
+
+    /* values are written as -ddd.dd and must be negative */
+    if (musicId == NULL || strchr(musicId, ' ') != NULL || loudness >= 0 ||
+        loudness <= -100) {
+        return;
+    }
+
+    bool found;
+    const size_t i = BarLoudnessDbFind(db, musicId, &found);
+    if (found) {
+        db->entry[i].loudness = loudness;
+    } else {
+        BarLoudnessDbGrow(db);
+        memmove(&db->entry[i + 1], &db->entry[i],
+                (db->count - i) * sizeof(*db->entry));
+        db->entry[i].musicId = strdup(musicId);
+        db->entry[i].loudness = loudness;
+        ++db->count;
+    }
+
+    FILE *const fp = fopen(db->path, "a");
+    if (fp == NULL) {
+        return;
+    }
+    const int centi = (int)lroundf(-loudness * 100.0f);
+    fprintf(fp, "%s -%d.%02d\n", musicId, centi / 100, centi % 100);
+    fclose(fp);
+}
@@ -0,0 +1,78 @@
+/*
+Copyright (c) 2026
+        pianobar contributors
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+
+#pragma once
+
+#include "config.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include <libavutil/frame.h>
+
+#define BAR_LOUDNESS_MAXCHANNELS 8
+
+/* biquad, direct form II transposed */
+typedef struct {
+    double b0, b1, b2, a1, a2;
+} BarLoudnessBiquad_t;
+
+/* EBU R128 integrated loudness meter */
+typedef struct {
+    int rate, channels;
+    /* K-weighting: high shelf followed by high pass */
+    BarLoudnessBiquad_t shelf, highpass;
+    double z[BAR_LOUDNESS_MAXCHANNELS][4];
+    /* 100 ms sub-blocks, a 400 ms gating block consists of four of them */
+    size_t subLen, subPos;
+    double subSum, sub[4];
+    unsigned int subCount;
+    /* mean square of every gating block */
+    double *blocks;
+    size_t blockCount, blockSize;
+    /* input format not supported, result is invalid */
+    bool failed;
+} BarLoudness_t;
+
+typedef struct {
+    char *musicId;
+    float loudness;
+} BarLoudnessEntry_t;
+
+/* measured loudness by musicId, sorted */
+typedef struct {
+    char *path;
+    BarLoudnessEntry_t *entry;
+    size_t count, size;
+} BarLoudnessDb_t;
+
+void BarLoudnessInit(BarLoudness_t *);
+void BarLoudnessDestroy(BarLoudness_t *);
+void BarLoudnessAdd(BarLoudness_t *, const AVFrame *);
+bool BarLoudnessIntegrated(const BarLoudness_t *, float *);
+
+void BarLoudnessDbLoad(BarLoudnessDb_t *, const char *);
+void BarLoudnessDbDestroy(BarLoudnessDb_t *);
+bool BarLoudnessDbGet(const BarLoudnessDb_t *, const char *, float *);
+void BarLoudnessDbPut(BarLoudnessDb_t *, const char *, float);
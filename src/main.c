@@ -29,6 +29,7 @@ THE SOFTWARE.
 #include <string.h>
 /* fork () */
 #include <ctype.h>
+#include <errno.h>
 #include <sys/select.h>
 #include <time.h>
 #include <unistd.h>
@@ -51,11 +52,112 @@ THE SOFTWARE.
 #include <piano.h>
 
 #include "main.h"
+#include "session.h"
 #include "terminal.h"
 #include "ui.h"
 #include "ui_dispatch.h"
 #include "ui_readline.h"
 
+/* the next song is started this long before it is faded in, milliseconds */
+#define BAR_CROSSFADE_PRELOAD 5000
+
+/*	milliseconds since startup
+ */
+static unsigned int BarMainStartupMs(const BarStartup_t *const startup) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - startup->origin.tv_sec) * 1000 +
+           (now.tv_nsec - startup->origin.tv_nsec) / 1000000;
+}
+
+/*	record start of a startup phase, phases are timed until the first song
+ *	starts playing
+ */
+static void BarMainPhaseBegin(BarApp_t *app, const BarStartupPhase_t phase) {
+    BarStartup_t *const startup = &app->startup;
+
+    if (startup->firstSong != 0 || startup->ran[phase]) {
+        return;
+    }
+    startup->ran[phase] = true;
+    startup->start[phase] = BarMainStartupMs(startup);
+}
+
+/*	record end of a startup phase
+ */
+static void BarMainPhaseEnd(BarApp_t *app, const BarStartupPhase_t phase) {
+    BarStartup_t *const startup = &app->startup;
+
+    if (!startup->ran[phase] || startup->ended[phase]) {
+        return;
+    }
+    startup->ended[phase] = true;
+    startup->end[phase] = BarMainStartupMs(startup);
+}
+
+/*	set up codecs, filters and audio output, runs in its own thread while
+ *	the main thread logs in
+ */
+static void *BarMainInitAudio(void *data) {
+    BarApp_t *const app = data;
+
+    /* the main thread is printing login output meanwhile, errors are shown
+     * by BarMainWaitAudio. Printed right away if this fails. */
+    FILE *const msgs =
+        open_memstream(&app->audioInitMsgs, &app->audioInitMsgsSize);
+    BarUiMsgCapture(msgs);
+
+    BarPlayerInit();
+
+    /* catch typos in the filter description before anything is played */
+    app->audioOk = BarPlayerCheckFilter(&app->settings);
+    BarPlayerGraphCacheInit(&app->graphCache);
+    if (app->settings.loudnessNormalize) {
+        BarLoudnessDbLoad(&app->loudness, app->settings.loudnessDb);
+    }
+
+    if (app->settings.pcmTap != NULL) {
+        app->tap = BarTapOpen(app->settings.pcmTap, app->settings.pcmTapMs);
+        if (app->tap == NULL) {
+            BarUiMsg(&app->settings, MSG_ERR, "Cannot create pcm tap %s (%s)\n",
+                     app->settings.pcmTap, strerror(errno));
+        }
+    }
+
+    if (!BarSinksInit(&app->sinks, &app->settings, app->tap)) {
+        BarUiMsg(&app->settings, MSG_ERR, "No usable audio sink configured.\n");
+    }
+
+    BarMainPhaseEnd(app, BAR_PHASE_AUDIO);
+
+    BarUiMsgCapture(NULL);
+    if (msgs != NULL) {
+        fclose(msgs);
+    }
+
+    return NULL;
+}
+
+/*	wait for audio initialization, anything touching the player, sinks or
+ *	loudness database must call this first
+ *	@return false if audio cannot work
+ */
+static bool BarMainWaitAudio(BarApp_t *app) {
+    if (app->audioInitRunning) {
+        BarMainPhaseBegin(app, BAR_PHASE_AUDIOWAIT);
+        pthread_join(app->audioInit, NULL);
+        app->audioInitRunning = false;
+        BarMainPhaseEnd(app, BAR_PHASE_AUDIOWAIT);
+    }
+    if (app->audioInitMsgs != NULL) {
+        fputs(app->audioInitMsgs, stdout);
+        fflush(stdout);
+        free(app->audioInitMsgs);
+        app->audioInitMsgs = NULL;
+    }
+    return app->audioOk;
+}
+
 /*	authenticate user
  */
 static bool BarMainLoginUser(BarApp_t *app) {
@@ -70,7 +172,7 @@ static bool BarMainLoginUser(BarApp_t *app) {
 
     BarUiMsg(&app->settings, MSG_INFO, "Login... ");
     ret = BarUiPianoCall(app, PIANO_REQUEST_LOGIN, &reqData, &pRet, &wRet);
-    BarUiStartEventCmd(&app->settings, "userlogin", NULL, NULL, &app->player,
+    BarUiStartEventCmd(&app->settings, "userlogin", NULL, NULL, app->player,
                        NULL, pRet, wRet);
 
     return ret;
@@ -204,17 +306,97 @@ static bool BarMainGetStations(BarApp_t *app) {
     BarUiMsg(&app->settings, MSG_INFO, "Get stations... ");
     ret = BarUiPianoCall(app, PIANO_REQUEST_GET_STATIONS, NULL, &pRet, &wRet);
     BarUiStartEventCmd(&app->settings, "usergetstations", NULL, NULL,
-                       &app->player, app->ph.stations, pRet, wRet);
+                       app->player, &app->ph, pRet, wRet);
     return ret;
 }
 
+/*	station list received in the background
+ */
+static void BarMainStationsDone(BarRpcCall_t *const call, void *const data) {
+    BarApp_t *const app = data;
+    PianoStation_t *const removed = app->stationsReq.retRemoved;
+
+    app->stationsReq.retRemoved = NULL;
+    if (call->pRet != PIANO_RET_OK || call->wRet != CURLE_OK) {
+        PianoDestroyStations(removed);
+        return;
+    }
+
+    /* someone may still hold a pointer to them, see BarMainReapStations */
+    if (app->removedStations == NULL) {
+        app->removedStations = removed;
+    } else {
+        PianoStation_t *tail = app->removedStations;
+        while (PianoListNextP(tail) != NULL) {
+            tail = PianoListNextP(tail);
+        }
+        tail->head.next = &removed->head;
+    }
+    for (const PianoStation_t *s = removed; s != NULL; s = PianoListNextP(s)) {
+        if (s == app->nextStation) {
+            app->nextStation = NULL;
+        }
+    }
+
+    BarUiStartEventCmd(&app->settings, "usergetstations", NULL, NULL,
+                       app->player, &app->ph, PIANO_RET_OK, CURLE_OK);
+    BarSessionSave(&app->ph, &app->settings);
+}
+
+/*	fetch stations only if they changed since the session was saved
+ */
+static void BarMainStationsChecksumDone(BarRpcCall_t *const call,
+                                        void *const data) {
+    BarApp_t *const app = data;
+
+    if (call->pRet == PIANO_RET_OK && call->wRet == CURLE_OK &&
+        app->stationsChecksumReq.retChanged) {
+        BarRpcSubmit(&app->rpc, PIANO_REQUEST_GET_STATIONS, &app->stationsReq,
+                     NULL, BarMainStationsDone, app);
+    }
+}
+
+/*	free stations deleted elsewhere, unless they are still playing
+ */
+static void BarMainReapStations(BarApp_t *app) {
+    PianoStation_t *s = app->removedStations;
+    while (s != NULL) {
+        PianoStation_t *const next = PianoListNextP(s);
+        if (s != app->curStation && s != app->nextStation) {
+            app->removedStations = PianoListDeleteP(app->removedStations, s);
+            s->head.next = NULL;
+            PianoDestroyStations(s);
+        }
+        s = next;
+    }
+}
+
+/*	continue where the last session left off, the first call with an expired
+ *	token logs in again
+ */
+static bool BarMainResumeSession(BarApp_t *app) {
+    if (!BarSessionLoad(&app->ph, &app->settings)) {
+        return false;
+    }
+
+    BarUiMsg(&app->settings, MSG_INFO, "Resuming session... Ok.\n");
+    BarUiStartEventCmd(&app->settings, "usergetstations", NULL, NULL,
+                       app->player, &app->ph, PIANO_RET_OK, CURLE_OK);
+
+    /* the cached station list is used until pandora says otherwise */
+    BarRpcSubmit(&app->rpc, PIANO_REQUEST_GET_STATIONS_CHECKSUM,
+                 &app->stationsChecksumReq, NULL, BarMainStationsChecksumDone,
+                 app);
+    return true;
+}
+
 /*	get initial station from autostart setting or user input
  */
 static void BarMainGetInitialStation(BarApp_t *app) {
     /* try to get autostart station */
     if (app->settings.autostartStation != NULL) {
-        app->nextStation = PianoFindStationById(app->ph.stations,
-                                                app->settings.autostartStation);
+        app->nextStation =
+            PianoFindStationById(&app->ph, app->settings.autostartStation);
         if (app->nextStation == NULL) {
             BarUiMsg(&app->settings, MSG_ERR,
                      "Error: Autostart station not found.\n");
@@ -232,37 +414,179 @@ static void BarMainGetInitialStation(BarApp_t *app) {
  */
 static void BarMainHandleUserInput(BarApp_t *app) {
     char buf[2];
+    /* api calls in the background make progress while waiting */
+    if (!BarRpcWait(&app->rpc, &app->input, 1000, NULL)) {
+        return;
+    }
     if (BarReadline(buf, sizeof(buf), NULL, &app->input,
-                    BAR_RL_FULLRETURN | BAR_RL_NOECHO | BAR_RL_NOINT, 1) > 0) {
+                    BAR_RL_FULLRETURN | BAR_RL_NOECHO | BAR_RL_NOINT, 0) > 0) {
+        /* actions may touch the audio output */
+        if (!BarMainWaitAudio(app)) {
+            app->doQuit = 1;
+            return;
+        }
         BarUiDispatch(app, buf[0], app->curStation, app->playlist, true,
                       BAR_DC_GLOBAL);
     }
 }
 
-/*	fetch new playlist
+/*	new playlist received
  */
-static void BarMainGetPlaylist(BarApp_t *app) {
-    PianoReturn_t pRet;
-    CURLcode wRet;
-    PianoRequestDataGetPlaylist_t reqData;
-    reqData.station = app->nextStation;
-    reqData.quality = app->settings.audioQuality;
-
-    BarUiMsg(&app->settings, MSG_INFO, "Receiving new playlist... ");
-    if (!BarUiPianoCall(app, PIANO_REQUEST_GET_PLAYLIST, &reqData, &pRet,
-                        &wRet)) {
-        app->nextStation = NULL;
+static void BarMainPlaylistDone(BarRpcCall_t *const call, void *const data) {
+    BarApp_t *const app = data;
+
+    app->playlistCall = NULL;
+    BarMainPhaseEnd(app, BAR_PHASE_PLAYLIST);
+    if (app->playlistPrefetch) {
+        /* errors are reported by the regular fetch, if it is needed */
+        PianoSong_t *const fetched = app->playlistReq.retPlaylist;
+        if (call->pRet != PIANO_RET_OK || call->wRet != CURLE_OK ||
+            fetched == NULL) {
+            /* nothing to append */
+        } else if (app->playlist == NULL) {
+            app->playlist = fetched;
+        } else {
+            PianoSong_t *last = app->playlist;
+            while (PianoListNextP(last) != NULL) {
+                last = PianoListNextP(last);
+            }
+            last->head.next = &fetched->head;
+        }
     } else {
-        app->playlist = reqData.retPlaylist;
-        if (app->playlist == NULL) {
-            BarUiMsg(&app->settings, MSG_INFO, "No tracks left.\n");
+        if (!BarUiPianoResult(&app->settings, call->pRet, call->wRet)) {
             app->nextStation = NULL;
+        } else {
+            app->playlist = app->playlistReq.retPlaylist;
+            if (app->playlist == NULL) {
+                BarUiMsg(&app->settings, MSG_INFO, "No tracks left.\n");
+                app->nextStation = NULL;
+            }
         }
+        app->curStation = app->nextStation;
     }
-    app->curStation = app->nextStation;
     BarUiStartEventCmd(&app->settings, "stationfetchplaylist", app->curStation,
-                       app->playlist, &app->player, app->ph.stations, pRet,
-                       wRet);
+                       app->playlist, app->player, &app->ph, call->pRet,
+                       call->wRet);
+}
+
+/*	fetch new playlist in the background, playback starts once it arrived
+ *	@param app
+ *	@param prefetch: append to the playlist of the current station quietly
+ */
+static void BarMainGetPlaylist(BarApp_t *app, const bool prefetch) {
+    if (app->playlistCall != NULL) {
+        return;
+    }
+
+    memset(&app->playlistReq, 0, sizeof(app->playlistReq));
+    app->playlistReq.station = app->nextStation;
+    app->playlistReq.quality = app->settings.audioQuality;
+    app->playlistPrefetch = prefetch;
+
+    if (!prefetch) {
+        BarUiMsg(&app->settings, MSG_INFO, "Receiving new playlist... ");
+    }
+    app->playlistCall =
+        BarRpcSubmit(&app->rpc, PIANO_REQUEST_GET_PLAYLIST, &app->playlistReq,
+                     NULL, BarMainPlaylistDone, app);
+    if (app->playlistCall == NULL && !prefetch) {
+        BarUiMsg(&app->settings, MSG_NONE, "Out of memory.\n");
+        app->nextStation = NULL;
+    }
+}
+
+/*	request the next playlist while the current song is playing, once no
+ *	more than playlist_prefetch songs are left
+ */
+static void BarMainPrefetchPlaylist(BarApp_t *app) {
+    const PianoSong_t *const curSong = app->playlist;
+
+    if (app->settings.playlistPrefetch < 0 || app->playlistCall != NULL ||
+        curSong == NULL || curSong == app->prefetchSong ||
+        app->curStation == NULL || app->nextStation != app->curStation ||
+        app->player->mode != PLAYER_PLAYING) {
+        return;
+    }
+
+    const size_t upcoming = PianoListCountP(curSong) - 1;
+    if (upcoming > (size_t)app->settings.playlistPrefetch) {
+        return;
+    }
+
+    /* at most once per song, i.e. if the station has no tracks left */
+    app->prefetchSong = curSong;
+    BarMainGetPlaylist(app, true);
+}
+
+/*	renew auth token in the background, before it expires
+ */
+static void BarMainRefreshAuth(BarApp_t *app) {
+    const unsigned int interval = app->settings.reauthInterval;
+
+    if (interval == 0 || app->ph.user.authToken == NULL ||
+        app->rpc.reauth != NULL ||
+        time(NULL) - app->ph.user.authTime < (time_t)interval) {
+        return;
+    }
+    BarRpcRefreshAuth(&app->rpc);
+}
+
+/*	move finished song to history
+ */
+static void BarMainPopSong(BarApp_t *app) {
+    if (app->playlist != NULL) {
+        PianoSong_t *histsong = app->playlist;
+        app->playlist = PianoListNextP(app->playlist);
+        histsong->head.next = NULL;
+        BarUiHistoryPrepend(app, histsong);
+    }
+    /* the next song may prefetch again */
+    app->prefetchSong = NULL;
+}
+
+/*	avoid playing local files
+ */
+static bool BarMainIsPlayable(const PianoSong_t *const song) {
+    static const char httpPrefix[] = "http://";
+    return song->audioUrl != NULL &&
+           strncmp(song->audioUrl, httpPrefix, strlen(httpPrefix)) == 0;
+}
+
+/*	set up player for song, songId must be set by the caller
+ */
+static void BarMainSetupPlayer(BarApp_t *app, player_t *const player,
+                               const PianoSong_t *const song) {
+    memset(player, 0, sizeof(*player));
+
+    player->url = song->audioUrl;
+    player->artist = song->artist;
+    player->album = song->album;
+    player->title = song->title;
+    player->album_art = song->coverArt;
+    player->station = app->curStation->name;
+    player->gain = song->fileGain;
+    if (app->settings.loudnessNormalize) {
+        /* measured loudness is more reliable than pandora’s gain */
+        float loudness;
+        if (BarLoudnessDbGet(&app->loudness, song->musicId, &loudness)) {
+            player->gain = app->settings.loudnessTarget - loudness;
+        } else {
+            player->analyze = true;
+        }
+    }
+    player->settings = &app->settings;
+    player->sinks = &app->sinks;
+    player->graphCache = &app->graphCache;
+    player->songDuration = song->length;
+    pthread_mutex_init(&player->pauseMutex, NULL);
+    pthread_cond_init(&player->pauseCond, NULL);
+}
+
+/*	thread handle of player
+ */
+static pthread_t *BarMainPlayerThread(BarApp_t *app, pthread_t *playerThread,
+                                      const player_t *const player) {
+    return &playerThread[player - app->players];
 }
 
 /*	start new player thread
@@ -277,60 +601,150 @@ static void BarMainStartPlayback(BarApp_t *app, pthread_t *playerThread) {
     BarUiPrintSong(
         &app->settings, curSong,
         app->curStation->isQuickMix
-            ? PianoFindStationById(app->ph.stations, curSong->stationId)
+            ? PianoFindStationById(&app->ph, curSong->stationId)
             : NULL);
 
-    static const char httpPrefix[] = "http://";
-    /* avoid playing local files */
-    if (curSong->audioUrl == NULL ||
-        strncmp(curSong->audioUrl, httpPrefix, strlen(httpPrefix)) != 0) {
+    if (!BarMainIsPlayable(curSong)) {
         BarUiMsg(&app->settings, MSG_ERR, "Invalid song url.\n");
+        BarMainPopSong(app);
     } else {
         /* setup player */
-        memset(&app->player, 0, sizeof(app->player));
-
-        app->player.url = curSong->audioUrl;
-        app->player.artist = curSong->artist;
-        app->player.album = curSong->album;
-        app->player.title = curSong->title;
-        app->player.album_art = curSong->coverArt;
-        app->player.station = app->curStation->name;
-        app->player.gain = curSong->fileGain;
-        app->player.settings = &app->settings;
-        app->player.songDuration = curSong->length;
-        pthread_mutex_init(&app->player.pauseMutex, NULL);
-        pthread_cond_init(&app->player.pauseCond, NULL);
+        BarMainSetupPlayer(app, app->player, curSong);
+        app->player->songId = BarSinksNewSong(&app->sinks);
 
         assert(interrupted == &app->doQuit);
-        interrupted = &app->player.interrupted;
+        interrupted = &app->player->interrupted;
+
+        if (app->startup.firstSong == 0) {
+            const unsigned int ms = BarMainStartupMs(&app->startup);
+            app->startup.firstSong = ms > 0 ? ms : 1;
+        }
 
         /* throw event */
         BarUiStartEventCmd(&app->settings, "songstart", app->curStation,
-                           curSong, &app->player, app->ph.stations,
-                           PIANO_RET_OK, CURLE_OK);
+                           curSong, app->player, &app->ph, PIANO_RET_OK,
+                           CURLE_OK);
 
         /* prevent race condition, mode must _not_ be DEAD if
          * thread has been started */
-        app->player.mode = PLAYER_WAITING;
+        app->player->mode = PLAYER_WAITING;
         /* start player */
-        pthread_create(playerThread, NULL, BarPlayerThread, &app->player);
+        pthread_create(BarMainPlayerThread(app, playerThread, app->player),
+                       NULL, BarPlayerThread, app->player);
     }
 }
 
+/*	start the next song early, so it can be faded in
+ */
+static void BarMainStartCrossfade(BarApp_t *app, pthread_t *playerThread) {
+    const unsigned int fade = app->settings.crossfadeMs;
+    player_t *const cur = app->player;
+
+    if (fade == 0 || app->nextPlayer != NULL || app->playlist == NULL ||
+        cur->mode != PLAYER_PLAYING || cur->doQuit || cur->doPause) {
+        return;
+    }
+
+    /* no crossfade if the prefetched playlist did not arrive yet */
+    const PianoSong_t *const next = PianoListNextP(app->playlist);
+    if (next == NULL || !BarMainIsPlayable(next)) {
+        return;
+    }
+
+    const unsigned int duration = cur->songDuration * 1000;
+    if (duration < 2 * fade ||
+        BarPlayerPosition(cur) + fade + BAR_CROSSFADE_PRELOAD < duration) {
+        return;
+    }
+
+    const uint32_t songId = BarSinksNewSong(&app->sinks);
+    if (!BarSinksCrossfade(&app->sinks, cur->songId, songId, duration - fade,
+                           fade, app->settings.crossfadeCurve)) {
+        return;
+    }
+
+    player_t *const player = cur == &app->players[0] ? &app->players[1]
+                                                     : &app->players[0];
+    BarMainSetupPlayer(app, player, next);
+    player->songId = songId;
+    player->mode = PLAYER_WAITING;
+    pthread_create(BarMainPlayerThread(app, playerThread, player), NULL,
+                   BarPlayerThread, player);
+    app->nextPlayer = player;
+}
+
+/*	make the song faded in the current one, its player is running already
+ *	@return false if there is no such song
+ */
+static bool BarMainPromoteNext(BarApp_t *app, pthread_t *playerThread) {
+    player_t *const next = app->nextPlayer;
+
+    if (next == NULL) {
+        return false;
+    }
+    app->nextPlayer = NULL;
+
+    /* it is the first song of the playlist now */
+    const PianoSong_t *const curSong = app->playlist;
+    assert(curSong != NULL);
+
+    if (next->doQuit) {
+        /* skipped before it became audible, i.e. station changed */
+        pthread_join(*BarMainPlayerThread(app, playerThread, next), NULL);
+        pthread_cond_destroy(&next->pauseCond);
+        pthread_mutex_destroy(&next->pauseMutex);
+        BarLoudnessDestroy(&next->loudness);
+        memset(next, 0, sizeof(*next));
+
+        PianoSong_t *const skipped = app->playlist;
+        app->playlist = PianoListNextP(skipped);
+        skipped->head.next = NULL;
+        PianoDestroyPlaylist(skipped);
+        return false;
+    }
+
+    app->player = next;
+
+    BarUiPrintSong(
+        &app->settings, curSong,
+        app->curStation->isQuickMix
+            ? PianoFindStationById(&app->ph, curSong->stationId)
+            : NULL);
+
+    assert(interrupted == &app->doQuit);
+    interrupted = &app->player->interrupted;
+
+    BarUiStartEventCmd(&app->settings, "songstart", app->curStation, curSong,
+                       app->player, &app->ph, PIANO_RET_OK, CURLE_OK);
+
+    return true;
+}
+
 /*	player is done, clean up
  */
 static void BarMainPlayerCleanup(BarApp_t *app, pthread_t *playerThread) {
     void *threadRet;
 
     BarUiStartEventCmd(&app->settings, "songfinish", app->curStation,
-                       app->playlist, &app->player, app->ph.stations,
-                       PIANO_RET_OK, CURLE_OK);
+                       app->playlist, app->player, &app->ph, PIANO_RET_OK,
+                       CURLE_OK);
 
     /* FIXME: pthread_join blocks everything if network connection
      * is hung up e.g. */
     pthread_join(*playerThread, &threadRet);
-    pthread_cond_destroy(&app->player.pauseCond);
-    pthread_mutex_destroy(&app->player.pauseMutex);
+    pthread_cond_destroy(&app->player->pauseCond);
+    pthread_mutex_destroy(&app->player->pauseMutex);
+
+    float loudness;
+    if (app->player->analyze && app->player->reachedEnd &&
+        app->playlist != NULL &&
+        BarLoudnessIntegrated(&app->player->loudness, &loudness)) {
+        BarLoudnessDbPut(&app->loudness, app->playlist->musicId, loudness);
+    }
+    BarLoudnessDestroy(&app->player->loudness);
+
+    BarPlayerCountersAdd(&app->counters, &app->player->counters);
+    ++app->songsPlayed;
 
     if (threadRet == (void *)PLAYER_RET_OK) {
         app->playerErrors = 0;
@@ -344,9 +758,9 @@ static void BarMainPlayerCleanup(BarApp_t *app, pthread_t *playerThread) {
         app->nextStation = NULL;
     }
 
-    memset(&app->player, 0, sizeof(app->player));
+    memset(app->player, 0, sizeof(*app->player));
 
-    assert(interrupted == &app->player.interrupted);
+    assert(interrupted == &app->player->interrupted);
     interrupted = &app->doQuit;
 }
 
@@ -355,24 +769,26 @@ static void BarMainPlayerCleanup(BarApp_t *app, pthread_t *playerThread) {
 static void BarMainPrintTime(BarApp_t *app) {
     unsigned int songRemaining;
     char sign;
+    const unsigned int songPlayed = BarPlayerPosition(app->player) / 1000;
 
-    if (app->player.songPlayed <= app->player.songDuration) {
-        songRemaining = app->player.songDuration - app->player.songPlayed;
+    if (songPlayed <= app->player->songDuration) {
+        songRemaining = app->player->songDuration - songPlayed;
         sign = '-';
     } else {
         /* longer than expected */
-        songRemaining = app->player.songPlayed - app->player.songDuration;
+        songRemaining = songPlayed - app->player->songDuration;
         sign = '+';
     }
     BarUiMsg(&app->settings, MSG_TIME, "%c%02u:%02u/%02u:%02u\r", sign,
              songRemaining / 60, songRemaining % 60,
-             app->player.songDuration / 60, app->player.songDuration % 60);
+             app->player->songDuration / 60, app->player->songDuration % 60);
 }
 
 /*	main loop
  */
 static void BarMainLoop(BarApp_t *app) {
-    pthread_t playerThread;
+    /* one for every player slot */
+    pthread_t playerThread[2];
 
     BarMainCheckSaveDirectory(&app->settings);
 
@@ -380,62 +796,95 @@ static void BarMainLoop(BarApp_t *app) {
         return;
     }
 
-    if (!BarMainLoginUser(app)) {
-        return;
-    }
+    BarMainPhaseBegin(app, BAR_PHASE_LOGIN);
+    if (!BarMainResumeSession(app)) {
+        if (!BarMainLoginUser(app)) {
+            return;
+        }
+        BarMainPhaseEnd(app, BAR_PHASE_LOGIN);
 
-    if (!BarMainGetStations(app)) {
-        return;
+        BarMainPhaseBegin(app, BAR_PHASE_STATIONS);
+        if (!BarMainGetStations(app)) {
+            return;
+        }
+        BarMainPhaseEnd(app, BAR_PHASE_STATIONS);
+
+        BarSessionSave(&app->ph, &app->settings);
     }
+    BarMainPhaseEnd(app, BAR_PHASE_LOGIN);
 
+    BarMainPhaseBegin(app, BAR_PHASE_SELECT);
     BarMainGetInitialStation(app);
+    BarMainPhaseEnd(app, BAR_PHASE_SELECT);
 
     /* little hack, needed to signal: hey! we need a playlist, but don't
      * free anything (there is nothing to be freed yet) */
-    memset(&app->player, 0, sizeof(app->player));
+    memset(app->players, 0, sizeof(app->players));
+    app->player = &app->players[0];
+    app->nextPlayer = NULL;
 
     while (!app->doQuit) {
+        BarMainReapStations(app);
+
         /* song finished playing, clean up things/scrobble song */
-        if (app->player.mode == PLAYER_FINISHED) {
-            if (app->player.interrupted != 0) {
+        if (app->player->mode == PLAYER_FINISHED) {
+            if (app->player->interrupted != 0) {
                 app->doQuit = 1;
             }
-            BarMainPlayerCleanup(app, &playerThread);
+            BarMainPlayerCleanup(
+                app, BarMainPlayerThread(app, playerThread, app->player));
+            BarMainPopSong(app);
         }
 
         /* check whether player finished playing and start playing new
          * song */
-        if (app->player.mode == PLAYER_DEAD) {
+        if (app->player->mode == PLAYER_DEAD &&
+            !BarMainPromoteNext(app, playerThread)) {
             /* what's next? */
-            if (app->playlist != NULL) {
-                PianoSong_t *histsong = app->playlist;
-                app->playlist = PianoListNextP(app->playlist);
-                histsong->head.next = NULL;
-                BarUiHistoryPrepend(app, histsong);
-            }
             if (app->playlist == NULL && app->nextStation != NULL &&
-                !app->doQuit) {
+                app->playlistCall == NULL && !app->doQuit) {
                 if (app->nextStation != app->curStation) {
                     BarUiPrintStation(&app->settings, app->nextStation);
                 }
-                BarMainGetPlaylist(app);
+                BarMainPhaseBegin(app, BAR_PHASE_PLAYLIST);
+                BarMainGetPlaylist(app, false);
             }
             /* song ready to play */
             if (app->playlist != NULL) {
-                BarMainStartPlayback(app, &playerThread);
+                if (BarMainWaitAudio(app)) {
+                    BarMainStartPlayback(app, playerThread);
+                } else {
+                    app->doQuit = 1;
+                }
             }
         }
 
+        BarMainRefreshAuth(app);
+
+        BarJournalFlush(&app->journal);
+
+        BarMainPrefetchPlaylist(app);
+
         BarMainHandleUserInput(app);
 
+        BarMainStartCrossfade(app, playerThread);
+
         /* show time */
-        if (app->player.mode == PLAYER_PLAYING) {
+        if (app->player->mode == PLAYER_PLAYING) {
             BarMainPrintTime(app);
         }
     }
 
-    if (app->player.mode != PLAYER_DEAD) {
-        pthread_join(playerThread, NULL);
+    if (app->player->mode != PLAYER_DEAD) {
+        pthread_join(*BarMainPlayerThread(app, playerThread, app->player),
+                     NULL);
+    }
+    if (app->nextPlayer != NULL) {
+        player_t *const next = app->nextPlayer;
+        pthread_mutex_lock(&next->pauseMutex);
+        next->doQuit = true;
+        pthread_mutex_unlock(&next->pauseMutex);
+        pthread_join(*BarMainPlayerThread(app, playerThread, next), NULL);
     }
 }
 
@@ -460,6 +909,8 @@ int main(int argc, char **argv) {
     static BarApp_t app;
 
     memset(&app, 0, sizeof(app));
+    clock_gettime(CLOCK_MONOTONIC, &app.startup.origin);
+    BarMainPhaseBegin(&app, BAR_PHASE_INIT);
 
     /* save terminal attributes, before disabling echoing */
     BarTermInit();
@@ -473,7 +924,6 @@ int main(int argc, char **argv) {
     gcry_check_version(NULL);
     gcry_control(GCRYCTL_DISABLE_SECMEM, 0);
     gcry_control(GCRYCTL_INITIALIZATION_FINISHED, 0);
-    BarPlayerInit();
 
     BarSettingsInit(&app.settings);
     BarSettingsRead(&app.settings);
@@ -498,9 +948,20 @@ int main(int argc, char **argv) {
                  app.settings.keys[BAR_KS_HELP]);
     }
 
+    /* before starting the audio thread, ffmpeg may initialize the same tls
+     * library */
     curl_global_init(CURL_GLOBAL_DEFAULT);
-    app.http = curl_easy_init();
-    assert(app.http != NULL);
+    BarRpcInit(&app.rpc, &app.ph, &app.settings);
+    BarSearchCacheInit(&app.searchCache, app.settings.searchCacheSize,
+                       app.settings.searchCacheTtl, app.settings.searchCache);
+    BarJournalInit(&app.journal, &app.rpc, &app.settings);
+
+    BarMainPhaseBegin(&app, BAR_PHASE_AUDIO);
+    app.audioInitRunning =
+        pthread_create(&app.audioInit, NULL, BarMainInitAudio, &app) == 0;
+    if (!app.audioInitRunning) {
+        BarMainInitAudio(&app);
+    }
 
     /* init fds */
     FD_ZERO(&app.input.set);
@@ -530,7 +991,10 @@ int main(int argc, char **argv) {
                                                           : app.input.fds[1];
     ++app.input.maxfd;
 
+    BarMainPhaseEnd(&app, BAR_PHASE_INIT);
+
     BarMainLoop(&app);
+    BarMainWaitAudio(&app);
 
     if (app.input.fds[1] != -1) {
         close(app.input.fds[1]);
@@ -538,13 +1002,23 @@ int main(int argc, char **argv) {
 
     /* write statefile */
     BarSettingsWrite(app.curStation, &app.settings);
+    BarSessionSave(&app.ph, &app.settings);
 
+    BarJournalDestroy(&app.journal);
+    BarRpcDestroy(&app.rpc);
     PianoDestroy(&app.ph);
+    PianoDestroyStations(app.removedStations);
+    PianoDestroyGenreStations(app.genreReq.retCategories);
+    PianoDestroyGenreStations(app.genreUpdate);
+    BarSearchCacheDestroy(&app.searchCache);
     PianoDestroyPlaylist(app.songHistory);
     PianoDestroyPlaylist(app.playlist);
-    curl_easy_cleanup(app.http);
     curl_global_cleanup();
+    BarSinksDestroy(&app.sinks);
+    BarPlayerGraphCacheDestroy(&app.graphCache);
+    BarLoudnessDbDestroy(&app.loudness);
     BarPlayerDestroy();
+    BarTapClose(app.tap);
     BarSettingsDestroy(&app.settings);
 
     /* restore terminal attributes, zsh doesn't need this, bash does... */
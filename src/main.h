@@ -23,18 +23,76 @@ THE SOFTWARE.
 
 #pragma once
 
+#include <pthread.h>
+#include <stdbool.h>
+#include <time.h>
+
 #include <curl/curl.h>
 
 #include <piano.h>
 
+#include "journal.h"
+#include "loudness.h"
 #include "player.h"
+#include "rpc.h"
+#include "search.h"
 #include "settings.h"
+#include "sink.h"
+#include "tap.h"
 #include "ui_readline.h"
 
+/* startup phases, timed to find the critical path to the first song */
+typedef enum {
+  BAR_PHASE_INIT = 0,
+  /* codecs, filters and audio output, runs in the background */
+  BAR_PHASE_AUDIO,
+  BAR_PHASE_LOGIN,
+  BAR_PHASE_STATIONS,
+  /* includes waiting for the user without autostart_station */
+  BAR_PHASE_SELECT,
+  BAR_PHASE_PLAYLIST,
+  /* audio initialization was not done when it was needed */
+  BAR_PHASE_AUDIOWAIT,
+  BAR_PHASE_COUNT,
+} BarStartupPhase_t;
+
+typedef struct {
+  struct timespec origin;
+  /* milliseconds since origin */
+  unsigned int start[BAR_PHASE_COUNT], end[BAR_PHASE_COUNT];
+  bool ran[BAR_PHASE_COUNT], ended[BAR_PHASE_COUNT];
+  /* songstart event of the first song, 0 if there was none yet */
+  unsigned int firstSong;
+} BarStartup_t;
+
 typedef struct {
   PianoHandle_t ph;
-  CURL *http;
-  player_t player;
+  BarRpc_t rpc;
+  /* playlist fetch in progress and its request data */
+  BarRpcCall_t *playlistCall;
+  PianoRequestDataGetPlaylist_t playlistReq;
+  /* fetch is appended to the current playlist */
+  bool playlistPrefetch;
+  /* song that was playing when the last prefetch was started, reset when
+   * it is moved to the history */
+  const PianoSong_t *prefetchSong;
+  /* station list refresh in the background */
+  PianoRequestDataGetStationsChecksum_t stationsChecksumReq;
+  PianoRequestDataGetStations_t stationsReq;
+  /* stations deleted elsewhere, freed once they are not in use */
+  PianoStation_t *removedStations;
+  /* genre catalog refresh in the background and its result, which replaces
+   * ph.genreStations the next time they are shown */
+  BarRpcCall_t *genreCall;
+  PianoRequestDataGetGenreStations_t genreReq;
+  PianoGenreCategory_t *genreUpdate;
+  BarSearchCache_t searchCache;
+  /* feedback sent in the background */
+  BarJournal_t journal;
+  /* player points to the current song’s slot, nextPlayer (if not NULL) to
+   * the song being faded in */
+  player_t players[2];
+  player_t *player, *nextPlayer;
   BarSettings_t settings;
   /* first item is current song */
   PianoSong_t *playlist;
@@ -45,6 +103,20 @@ typedef struct {
   sig_atomic_t doQuit;
   BarReadlineFds_t input;
   unsigned int playerErrors;
+  BarTap_t *tap;
+  BarSinks_t sinks;
+  BarPlayerGraphCache_t graphCache;
+  BarLoudnessDb_t loudness;
+  /* thread initializing the above, while logging in */
+  pthread_t audioInit;
+  bool audioInitRunning, audioOk;
+  /* messages printed meanwhile, shown once it finished */
+  char *audioInitMsgs;
+  size_t audioInitMsgsSize;
+  BarStartup_t startup;
+  /* playback problems of all finished songs */
+  BarPlayerCounters_t counters;
+  unsigned int songsPlayed;
 } BarApp_t;
 
 #include <signal.h>
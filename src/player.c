@@ -27,14 +27,17 @@ THE SOFTWARE.
 
 #include <arpa/inet.h>
 #include <assert.h>
+#include <errno.h>
 #include <limits.h>
 #include <math.h>
 #include <stdint.h>
 #include <string.h>
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <time.h>
 #include <unistd.h>
 
+#include <ao/ao.h>
 #include <libavcodec/avcodec.h>
 #include <libavfilter/avfilter.h>
 #include <libavfilter/avfiltergraph.h>
@@ -99,9 +102,10 @@ void BarPlayerSetVolume(player_t *const player) {
     snprintf(
         strbuf, sizeof(strbuf), "%fdB",
         player->settings->volume + (player->gain * player->settings->gainMul));
-    assert(player->fgraph != NULL);
-    if ((ret = avfilter_graph_send_command(player->fgraph, "volume", "volume",
-                                           strbuf, NULL, 0, 0)) < 0) {
+    assert(player->graph.fgraph != NULL);
+    if ((ret = avfilter_graph_send_command(player->graph.fgraph, "mastervolume",
+                                           "volume", strbuf, NULL, 0, 0)) <
+        0) {
 #else
     /* convert from decibel */
     const double volume = pow(10, (player->settings->volume +
@@ -109,14 +113,40 @@ void BarPlayerSetVolume(player_t *const player) {
                                       20);
     /* libav does not provide other means to set this right now. it might not
      * even work everywhere. */
-    assert(player->fvolume != NULL);
-    if ((ret = av_opt_set_double(player->fvolume->priv, "volume", volume, 0)) !=
-        0) {
+    assert(player->graph.fvolume != NULL);
+    if ((ret = av_opt_set_double(player->graph.fvolume->priv, "volume", volume,
+                                 0)) != 0) {
 #endif
         printError(player->settings, "Cannot set volume", ret);
     }
 }
 
+/*	milliseconds of the current song played by the audio device, or decoded
+ *	if no sink is a device, can be called from any thread
+ */
+unsigned int BarPlayerPosition(const player_t *const player) {
+    if (player->sinks == NULL || !player->sinks->device) {
+        /* nothing paces playback, what was decoded has been written */
+        return player->songDecodedMs;
+    }
+    return BarSinksPosition(player->sinks, player->songId);
+}
+
+/*	add counters of one song to a running total
+ */
+void BarPlayerCountersAdd(BarPlayerCounters_t *const total,
+                          const BarPlayerCounters_t *const c) {
+    total->underruns += c->underruns;
+    total->stalls += c->stalls;
+    total->stallMs += c->stallMs;
+    total->decodeErrors += c->decodeErrors;
+    total->retries += c->retries;
+    total->filterBuilds += c->filterBuilds;
+    total->filterReuses += c->filterReuses;
+    total->filterSetupUs += c->filterSetupUs;
+    /* positions refer to a single song and are not meaningful here */
+}
+
 #define softfail(msg)                       \
     printError(player->settings, msg, ret); \
     return false;
@@ -336,38 +366,50 @@ static bool openStream(player_t *const player) {
     return true;
 }
 
-/*	setup filter chain
+static void graphFree(BarPlayerGraph_t *const g) {
+    if (g->fgraph != NULL) {
+        avfilter_graph_free(&g->fgraph);
+    }
+    memset(g, 0, sizeof(*g));
+}
+
+#define graphfail(msg) \
+    *failed = msg;     \
+    return ret;
+
+/*	build filter graph for the input parameters stored in g
+ *	@param graph, input parameters must be set
+ *	@param additional filter chain (audio_filter setting) or NULL
+ *	@param set to the failed step on error
+ *	@return av error code
  */
-static bool openFilter(player_t *const player) {
-    /* filter setup */
+static int graphBuild(BarPlayerGraph_t *const g, const char *const chain,
+                      const char **const failed) {
     char strbuf[256];
     int ret = 0;
-    AVCodecParameters *const cp = player->st->codecpar;
 
-    if ((player->fgraph = avfilter_graph_alloc()) == NULL) {
-        softfail("graph_alloc");
+    if ((g->fgraph = avfilter_graph_alloc()) == NULL) {
+        ret = AVERROR(ENOMEM);
+        graphfail("graph_alloc");
     }
 
     /* abuffer */
-    AVRational time_base = player->st->time_base;
-
     snprintf(strbuf, sizeof(strbuf),
              "time_base=%d/"
              "%d:sample_rate=%d:sample_fmt=%s:channel_layout=0x%" PRIx64,
-             time_base.num, time_base.den, cp->sample_rate,
-             av_get_sample_fmt_name(player->cctx->sample_fmt),
-             cp->channel_layout);
+             g->timeBase.num, g->timeBase.den, g->sampleRate,
+             av_get_sample_fmt_name(g->sampleFmt), g->channelLayout);
     if ((ret = avfilter_graph_create_filter(
-             &player->fabuf, avfilter_get_by_name("abuffer"), NULL, strbuf,
-             NULL, player->fgraph)) < 0) {
-        softfail("create_filter abuffer");
+             &g->fabuf, avfilter_get_by_name("abuffer"), NULL, strbuf, NULL,
+             g->fgraph)) < 0) {
+        graphfail("create_filter abuffer");
     }
 
-    /* volume */
+    /* volume, named so user filters are not affected by volume changes */
     if ((ret = avfilter_graph_create_filter(
-             &player->fvolume, avfilter_get_by_name("volume"), NULL, "0dB",
-             NULL, player->fgraph)) < 0) {
-        softfail("create_filter volume");
+             &g->fvolume, avfilter_get_by_name("volume"), "mastervolume",
+             "0dB", NULL, g->fgraph)) < 0) {
+        graphfail("create_filter volume");
     }
 
     /* aformat: convert float samples into something more usable */
@@ -376,53 +418,314 @@ static bool openFilter(player_t *const player) {
              av_get_sample_fmt_name(avformat));
     if ((ret = avfilter_graph_create_filter(
              &fafmt, avfilter_get_by_name("aformat"), NULL, strbuf, NULL,
-             player->fgraph)) < 0) {
-        softfail("create_filter aformat");
+             g->fgraph)) < 0) {
+        graphfail("create_filter aformat");
     }
 
     /* abuffersink */
     if ((ret = avfilter_graph_create_filter(
-             &player->fbufsink, avfilter_get_by_name("abuffersink"), NULL, NULL,
-             NULL, player->fgraph)) < 0) {
-        softfail("create_filter abuffersink");
+             &g->fbufsink, avfilter_get_by_name("abuffersink"), NULL, NULL,
+             NULL, g->fgraph)) < 0) {
+        graphfail("create_filter abuffersink");
     }
 
-    /* connect filter: abuffer -> volume -> aformat -> abuffersink */
-    if (avfilter_link(player->fabuf, 0, player->fvolume, 0) != 0 ||
-        avfilter_link(player->fvolume, 0, fafmt, 0) != 0 ||
-        avfilter_link(fafmt, 0, player->fbufsink, 0) != 0) {
-        softfail("filter_link");
+    /* connect filter: abuffer -> [chain] -> volume -> aformat -> abuffersink */
+    if (chain != NULL) {
+        AVFilterInOut *outputs = avfilter_inout_alloc();
+        AVFilterInOut *inputs = avfilter_inout_alloc();
+        if (outputs == NULL || inputs == NULL) {
+            avfilter_inout_free(&outputs);
+            avfilter_inout_free(&inputs);
+            ret = AVERROR(ENOMEM);
+            graphfail("inout_alloc");
+        }
+        outputs->name = av_strdup("in");
+        outputs->filter_ctx = g->fabuf;
+        outputs->pad_idx = 0;
+        outputs->next = NULL;
+        inputs->name = av_strdup("out");
+        inputs->filter_ctx = g->fvolume;
+        inputs->pad_idx = 0;
+        inputs->next = NULL;
+        ret = avfilter_graph_parse_ptr(g->fgraph, chain, &inputs, &outputs,
+                                       NULL);
+        avfilter_inout_free(&outputs);
+        avfilter_inout_free(&inputs);
+        if (ret < 0) {
+            graphfail("audio_filter");
+        }
+    } else if ((ret = avfilter_link(g->fabuf, 0, g->fvolume, 0)) != 0) {
+        graphfail("filter_link");
+    }
+    if ((ret = avfilter_link(g->fvolume, 0, fafmt, 0)) != 0 ||
+        (ret = avfilter_link(fafmt, 0, g->fbufsink, 0)) != 0) {
+        graphfail("filter_link");
     }
 
-    if ((ret = avfilter_graph_config(player->fgraph, NULL)) < 0) {
-        softfail("graph_config");
+    if ((ret = avfilter_graph_config(g->fgraph, NULL)) < 0) {
+        graphfail("graph_config");
     }
 
+    return 0;
+}
+
+#undef graphfail
+
+/*	validate the audio_filter setting once at startup
+ */
+bool BarPlayerCheckFilter(const BarSettings_t *const settings) {
+    if (settings->audioFilter == NULL) {
+        return true;
+    }
+
+    /* typical pandora stream */
+    BarPlayerGraph_t g;
+    memset(&g, 0, sizeof(g));
+    g.timeBase = (AVRational){1, 44100};
+    g.sampleRate = 44100;
+    g.sampleFmt = AV_SAMPLE_FMT_FLTP;
+    g.channelLayout = av_get_default_channel_layout(2);
+
+    const char *failed = NULL;
+    const int ret = graphBuild(&g, settings->audioFilter, &failed);
+    graphFree(&g);
+    if (ret < 0) {
+        printError(settings, "Invalid audio_filter", ret);
+        return false;
+    }
     return true;
 }
 
-/*	setup libao
+void BarPlayerGraphCacheInit(BarPlayerGraphCache_t *const cache) {
+    memset(cache, 0, sizeof(*cache));
+    pthread_mutex_init(&cache->mutex, NULL);
+}
+
+void BarPlayerGraphCacheDestroy(BarPlayerGraphCache_t *const cache) {
+    graphFree(&cache->graph);
+    pthread_mutex_destroy(&cache->mutex);
+}
+
+/*	setup filter chain, reuses the cached graph if possible
  */
-static bool openDevice(player_t *const player) {
+static bool openFilter(player_t *const player) {
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
     const AVCodecParameters *const cp = player->st->codecpar;
+    BarPlayerGraph_t *const g = &player->graph;
+    memset(g, 0, sizeof(*g));
+    g->timeBase = player->st->time_base;
+    g->sampleRate = cp->sample_rate;
+    g->sampleFmt = player->cctx->sample_fmt;
+    g->channelLayout = cp->channel_layout;
+
+    player->stats.filterReused = false;
+    BarPlayerGraphCache_t *const cache = player->graphCache;
+    if (cache != NULL) {
+        pthread_mutex_lock(&cache->mutex);
+        const BarPlayerGraph_t *const c = &cache->graph;
+        if (c->fgraph != NULL && c->timeBase.num == g->timeBase.num &&
+            c->timeBase.den == g->timeBase.den &&
+            c->sampleRate == g->sampleRate && c->sampleFmt == g->sampleFmt &&
+            c->channelLayout == g->channelLayout) {
+            *g = cache->graph;
+            memset(&cache->graph, 0, sizeof(cache->graph));
+            g->ptsOffset = g->nextPts;
+            player->stats.filterReused = true;
+        }
+        pthread_mutex_unlock(&cache->mutex);
+    }
+
+    if (!player->stats.filterReused) {
+        const char *failed = NULL;
+        const int ret = graphBuild(g, player->settings->audioFilter, &failed);
+        if (ret < 0) {
+            /* half-built, must not end up in the cache */
+            graphFree(g);
+            printError(player->settings, failed, ret);
+            return false;
+        }
+    }
 
-    ao_sample_format aoFmt;
-    memset(&aoFmt, 0, sizeof(aoFmt));
-    aoFmt.bits = av_get_bytes_per_sample(avformat) * 8;
-    assert(aoFmt.bits > 0);
-    aoFmt.channels = cp->channels;
-    aoFmt.rate = cp->sample_rate;
-    aoFmt.byte_format = AO_FMT_NATIVE;
-
-    int driver = ao_default_driver_id();
-    if ((player->aoDev = ao_open_live(driver, &aoFmt, NULL)) == NULL) {
-        BarUiMsg(player->settings, MSG_ERR, "Cannot open audio device.\n");
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    player->stats.filterSetupUs = (end.tv_sec - start.tv_sec) * 1000000 +
+                                  (end.tv_nsec - start.tv_nsec) / 1000;
+    if (player->stats.filterReused) {
+        player->counters.filterReuses++;
+    } else {
+        player->counters.filterBuilds++;
+    }
+    player->counters.filterSetupUs += player->stats.filterSetupUs;
+
+    return true;
+}
+
+/*	hand the filter graph back to the cache or destroy it
+ */
+static void closeFilter(player_t *const player) {
+    BarPlayerGraphCache_t *const cache = player->graphCache;
+
+    /* only drained graphs are empty, after a skip or an error filters may
+     * still hold audio */
+    if (cache != NULL && player->graph.fgraph != NULL && player->reachedEnd) {
+        pthread_mutex_lock(&cache->mutex);
+        graphFree(&cache->graph);
+        cache->graph = player->graph;
+        memset(&player->graph, 0, sizeof(player->graph));
+        pthread_mutex_unlock(&cache->mutex);
+    }
+    graphFree(&player->graph);
+}
+
+/*	setup output, sinks open their devices as soon as the first frame
+ *	arrives
+ */
+static bool openDevice(player_t *const player) {
+    if (player->sinks == NULL || player->sinks->count == 0) {
+        BarUiMsg(player->settings, MSG_ERR, "No audio sink available.\n");
+        return false;
+    }
+    BarSinksReset(player->sinks);
+    return true;
+}
+
+/* silence trimming state, see trimFrame */
+typedef struct {
+    bool enabled, leading;
+    int16_t threshold;
+    unsigned int maxMs;
+    /* samples (per channel) seen so far */
+    uint64_t samples;
+    /* silent frames withheld near the end of the song */
+    AVFrame **held;
+    size_t heldCount, heldSize;
+} BarPlayerTrim_t;
+
+/*	true if no sample exceeds threshold. Written as a max reduction without
+ *	early exit, so it can be vectorized.
+ */
+static bool isSilent(const int16_t *const pcm, const size_t samples,
+                     const int16_t threshold) {
+    int32_t peak = 0;
+    for (size_t i = 0; i < samples; i++) {
+        const int32_t v = pcm[i];
+        const int32_t a = v < 0 ? -v : v;
+        peak = a > peak ? a : peak;
+    }
+    return peak <= threshold;
+}
+
+static void trimInit(const player_t *const player, BarPlayerTrim_t *const t) {
+    const BarSettings_t *const settings = player->settings;
+
+    memset(t, 0, sizeof(*t));
+    t->enabled = settings->silenceTrimMs > 0;
+    /* do not trim again after reconnecting */
+    t->leading = t->enabled && player->lastTimestamp == 0;
+    t->maxMs = settings->silenceTrimMs;
+    /* at 0 dBFS and above everything would be silent */
+    const double threshold =
+        32767.0 * pow(10, settings->silenceThreshold / 20.0);
+    t->threshold = threshold < INT16_MAX ? threshold : INT16_MAX - 1;
+}
+
+/*	decide what to do with a filtered frame
+ *	@return true if it should be played now, false if it was dropped or
+ *		withheld
+ */
+static bool trimFrame(player_t *const player, BarPlayerTrim_t *const t,
+                      AVFrame *const frame) {
+    if (!t->enabled) {
+        return true;
+    }
+
+    const unsigned int channels =
+        av_get_channel_layout_nb_channels(frame->channel_layout);
+    const bool silent = isSilent((const int16_t *)frame->data[0],
+                                 frame->nb_samples * channels, t->threshold);
+    const uint64_t ms = t->samples * 1000 / frame->sample_rate;
+    t->samples += frame->nb_samples;
+
+    if (t->leading) {
+        if (silent && ms < t->maxMs) {
+            player->stats.trimmedMs += frame->nb_samples * 1000 /
+                                       frame->sample_rate;
+            return false;
+        }
+        t->leading = false;
+    }
+
+    /* hold back silence at the end, it is dropped if nothing follows */
+    const uint64_t duration = (uint64_t)player->songDuration * 1000;
+    if (silent && duration > 0 && ms + t->maxMs >= duration) {
+        /* out of memory, play it instead */
+        if (t->heldCount >= t->heldSize) {
+            const size_t size = t->heldSize == 0 ? 64 : t->heldSize * 2;
+            AVFrame **const held = realloc(t->held, size * sizeof(*held));
+            if (held == NULL) {
+                return true;
+            }
+            t->held = held;
+            t->heldSize = size;
+        }
+        AVFrame *const copy = av_frame_clone(frame);
+        if (copy == NULL) {
+            return true;
+        }
+        t->held[t->heldCount++] = copy;
         return false;
     }
 
     return true;
 }
 
+/*	release withheld frames
+ *	@param play them (true) or drop them (false, end of song)
+ */
+static bool trimFlush(player_t *const player, BarPlayerTrim_t *const t,
+                      const bool play) {
+    bool ret = true;
+    for (size_t i = 0; i < t->heldCount; i++) {
+        AVFrame *frame = t->held[i];
+        if (play && ret) {
+            ret = BarSinksWrite(player->sinks, frame, player->songId,
+                                &player->doQuit);
+        } else if (!play) {
+            player->stats.trimmedMs += frame->nb_samples * 1000 /
+                                       frame->sample_rate;
+        }
+        av_frame_free(&frame);
+    }
+    t->heldCount = 0;
+    return ret;
+}
+
+/*	count a network read that took longer than the stall threshold
+ */
+static void countStall(player_t *const player,
+                       const struct timespec *const start) {
+    struct timespec end;
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    const unsigned long ms = (end.tv_sec - start->tv_sec) * 1000 +
+                             (end.tv_nsec - start->tv_nsec) / 1000000;
+    if (player->settings->stallThresholdMs > 0 &&
+        ms >= player->settings->stallThresholdMs) {
+        player->counters.stalls++;
+        player->counters.stallMs += ms;
+        player->counters.stallAt = BarPlayerPosition(player);
+    }
+}
+
+/*	count packets or frames rejected by the decoder
+ */
+static void countDecodeError(player_t *const player, const int ret) {
+    if (ret < 0 && ret != AVERROR(EAGAIN) && ret != AVERROR_EOF) {
+        player->counters.decodeErrors++;
+        player->counters.decodeErrorAt = BarPlayerPosition(player);
+    }
+}
+
 /*	decode and play stream. returns 0 or av error code.
  */
 static int play(player_t *const player) {
@@ -440,11 +743,18 @@ static int play(player_t *const player) {
     filteredFrame = av_frame_alloc();
     assert(filteredFrame != NULL);
 
+    BarPlayerTrim_t trim;
+    trimInit(player, &trim);
+
     enum { FILL, DRAIN, DONE } drainMode = FILL;
     int ret = 0;
+    bool deviceFailed = false;
     while (!player->doQuit && drainMode != DONE) {
         if (drainMode == FILL) {
+            struct timespec readStart;
+            clock_gettime(CLOCK_MONOTONIC, &readStart);
             ret = av_read_frame(player->fctx, &pkt);
+            countStall(player, &readStart);
             if (ret == AVERROR_EOF) {
                 /* enter drain mode */
                 drainMode = DRAIN;
@@ -458,7 +768,7 @@ static int play(player_t *const player) {
                 break;
             } else {
                 /* fill buffer */
-                avcodec_send_packet(cctx, &pkt);
+                countDecodeError(player, avcodec_send_packet(cctx, &pkt));
             }
         }
 
@@ -482,14 +792,16 @@ static int play(player_t *const player) {
         pthread_mutex_lock(&player->pauseMutex);
         if (player->doPause) {
             av_read_pause(player->fctx);
+            BarSinksPause(player->sinks, true);
             do {
                 pthread_cond_wait(&player->pauseCond, &player->pauseMutex);
             } while (player->doPause);
+            BarSinksPause(player->sinks, false);
             av_read_play(player->fctx);
         }
         pthread_mutex_unlock(&player->pauseMutex);
 
-        while (!player->doQuit) {
+        while (!player->doQuit && !deviceFailed) {
             ret = avcodec_receive_frame(cctx, frame);
             if (ret == AVERROR_EOF) {
                 /* done draining */
@@ -497,34 +809,60 @@ static int play(player_t *const player) {
                 break;
             } else if (ret != 0) {
                 /* no more output */
+                countDecodeError(player, ret);
                 break;
             }
 
+            if (player->analyze) {
+                BarLoudnessAdd(&player->loudness, frame);
+            }
+
             /* XXX: suppresses warning from resample filter */
             if (frame->pts == (int64_t)AV_NOPTS_VALUE) {
                 frame->pts = 0;
             }
-            ret = av_buffersrc_write_frame(player->fabuf, frame);
+            frame->pts += player->graph.ptsOffset;
+            player->graph.nextPts =
+                frame->pts +
+                av_rescale_q(frame->nb_samples,
+                             (AVRational){1, player->graph.sampleRate},
+                             player->graph.timeBase);
+            ret = av_buffersrc_write_frame(player->graph.fabuf, frame);
             assert(ret >= 0);
 
             while (true) {
-                if (av_buffersink_get_frame(player->fbufsink, filteredFrame) <
-                    0) {
+                if (av_buffersink_get_frame(player->graph.fbufsink,
+                                            filteredFrame) < 0) {
                     /* try again next frame */
                     break;
                 }
 
-                const int numChannels = av_get_channel_layout_nb_channels(
-                    filteredFrame->channel_layout);
-                const int bps = av_get_bytes_per_sample(filteredFrame->format);
-                ao_play(player->aoDev, (char *)filteredFrame->data[0],
-                        filteredFrame->nb_samples * numChannels * bps);
+                if (!trimFrame(player, &trim, filteredFrame)) {
+                    av_frame_unref(filteredFrame);
+                    continue;
+                }
 
+                const bool deviceOk =
+                    trimFlush(player, &trim, true) &&
+                    BarSinksWrite(player->sinks, filteredFrame,
+                                  player->songId, &player->doQuit);
                 av_frame_unref(filteredFrame);
+                if (!deviceOk) {
+                    BarUiMsg(player->settings, MSG_ERR,
+                             "Cannot open audio device.\n");
+                    deviceFailed = true;
+                    drainMode = DONE;
+                    break;
+                }
             }
         }
 
-        player->songPlayed = av_q2d(player->st->time_base) * (double)pkt.pts;
+        if (pkt.pts != (int64_t)AV_NOPTS_VALUE) {
+            player->songDecodedMs =
+                av_q2d(player->st->time_base) * (double)pkt.pts * 1000;
+        }
+        /* what is audible lags behind what was read */
+        player->songPlayed = BarPlayerPosition(player) / 1000;
         player->lastTimestamp = pkt.pts;
 
         av_packet_unref(&pkt);
@@ -532,17 +870,23 @@ static int play(player_t *const player) {
 
     av_frame_free(&filteredFrame);
     av_frame_free(&frame);
+    /* trailing silence */
+    trimFlush(player, &trim, false);
+    free(trim.held);
 
-    return ret;
+    player->reachedEnd =
+        drainMode == DONE && !deviceFailed && !player->doQuit;
+
+    if (player->doQuit) {
+        /* skipped, do not play what is left in the queues */
+        BarSinksFlush(player->sinks, player->songId);
+    }
+
+    return deviceFailed ? AVERROR(ENODEV) : ret;
 }
 
 static void finish(player_t *const player) {
-    ao_close(player->aoDev);
-    player->aoDev = NULL;
-    if (player->fgraph != NULL) {
-        avfilter_graph_free(&player->fgraph);
-        player->fgraph = NULL;
-    }
+    closeFilter(player);
     if (player->cctx != NULL) {
         avcodec_close(player->cctx);
         player->cctx = NULL;
@@ -561,16 +905,26 @@ void *BarPlayerThread(void *data) {
 
     player_t *const player = data;
     uintptr_t pret = PLAYER_RET_OK;
+    /* underruns are counted by the device sink for all songs */
+    const unsigned int underruns = BarSinksUnderruns(player->sinks);
 
     bool retry;
     do {
         retry = false;
+        player->reachedEnd = false;
         if (openStream(player)) {
             if (openFilter(player) && openDevice(player)) {
                 player->mode = PLAYER_PLAYING;
                 BarPlayerSetVolume(player);
-                retry =
-                    play(player) == AVERROR_INVALIDDATA && !player->interrupted;
+                const int ret = play(player);
+                if (ret == AVERROR(ENODEV)) {
+                    /* audio device busy */
+                    pret = PLAYER_RET_HARDFAIL;
+                }
+                retry = ret == AVERROR_INVALIDDATA && !player->interrupted;
+                if (retry) {
+                    player->counters.retries++;
+                }
             } else {
                 /* filter missing or audio device busy */
                 pret = PLAYER_RET_HARDFAIL;
@@ -583,6 +937,14 @@ void *BarPlayerThread(void *data) {
         finish(player);
     } while (retry);
 
+    /* let the next song take over if it is fading in */
+    if (player->sinks != NULL) {
+        BarSinksEndSong(player->sinks, player->songId);
+    }
+    player->counters.underruns = BarSinksUnderruns(player->sinks) - underruns;
+    player->counters.underrunAt =
+        BarSinksLastUnderrun(player->sinks, player->songId);
+
     player->mode = PLAYER_FINISHED;
 
     if (player->save_file && !player->doQuit) {
@@ -31,13 +31,50 @@ THE SOFTWARE.
 #include <stdint.h>
 #include <sys/types.h>
 
-#include <ao/ao.h>
 #include <libavfilter/avfilter.h>
 #include <libavfilter/avfiltergraph.h>
 #include <libavformat/avformat.h>
 #include <piano.h>
 
+#include "loudness.h"
 #include "settings.h"
+#include "sink.h"
+
+/* filter graph: abuffer -> [audio_filter] -> volume -> aformat -> abuffersink
+ */
+typedef struct {
+    AVFilterGraph *fgraph;
+    AVFilterContext *fabuf, *fvolume, *fbufsink;
+    /* input parameters the graph was configured for */
+    AVRational timeBase;
+    int sampleRate;
+    enum AVSampleFormat sampleFmt;
+    uint64_t channelLayout;
+    /* keeps timestamps monotonic if the graph is reused */
+    int64_t ptsOffset, nextPts;
+} BarPlayerGraph_t;
+
+/* configured graph kept across songs, reused if the input parameters of the
+ * next song are identical */
+typedef struct {
+    pthread_mutex_t mutex;
+    BarPlayerGraph_t graph;
+} BarPlayerGraphCache_t;
+
+/* playback problems, positions are song milliseconds of the latest one */
+typedef struct {
+    /* device ran out of audio */
+    unsigned int underruns, underrunAt;
+    /* network reads slower than stall_threshold_ms and their total duration */
+    unsigned int stalls, stallMs, stallAt;
+    /* packets or frames the decoder rejected */
+    unsigned int decodeErrors, decodeErrorAt;
+    /* stream reopened after invalid data */
+    unsigned int retries;
+    /* filter graphs built or taken from the cache and total setup time,
+     * microseconds */
+    unsigned int filterBuilds, filterReuses, filterSetupUs;
+} BarPlayerCounters_t;
 
 typedef struct {
     /* protected by pauseMutex */
@@ -58,20 +95,22 @@ typedef struct {
     } mode;
 
     /* libav */
-    AVFilterContext *fvolume;
-    AVFilterGraph *fgraph;
+    BarPlayerGraph_t graph;
+    BarPlayerGraphCache_t *graphCache;
     AVFormatContext *fctx;
     AVFormatContext *ofcx;
     AVPacket pkt_write;
     AVStream *ost;
     AVStream *st;
     AVCodecContext *cctx;
-    AVFilterContext *fbufsink, *fabuf;
     int streamIdx;
     int64_t lastTimestamp;
     sig_atomic_t interrupted;
 
-    ao_device *aoDev;
+    /* output, shared by all players */
+    BarSinks_t *sinks;
+    /* identifies our frames in the sinks, see BarSinksNewSong */
+    uint32_t songId;
 
     /* settings */
     double gain;
@@ -86,14 +125,38 @@ typedef struct {
     char save_complete[1000];
     const BarSettings_t *settings;
 
-    /* measured in seconds */
+    /* measured in seconds, songPlayed follows the device; use
+     * BarPlayerPosition for sub-second resolution */
     volatile unsigned int songDuration;
     volatile unsigned int songPlayed;
+    /* milliseconds decoded, the position if no sink plays in real time */
+    volatile unsigned int songDecodedMs;
+    /* decoded until end of stream */
+    bool reachedEnd;
+
+    /* loudness measurement, if enabled and song is not in the cache */
+    bool analyze;
+    BarLoudness_t loudness;
+
+    /* statistics */
+    struct {
+        /* time spent setting up the filter graph, microseconds */
+        unsigned int filterSetupUs;
+        bool filterReused;
+        /* silence removed at the beginning and end, milliseconds */
+        unsigned int trimmedMs;
+    } stats;
+    BarPlayerCounters_t counters;
 } player_t;
 
 enum { PLAYER_RET_OK = 0, PLAYER_RET_HARDFAIL = 1, PLAYER_RET_SOFTFAIL = 2 };
 
 void *BarPlayerThread(void *data);
 void BarPlayerSetVolume(player_t *const player);
+unsigned int BarPlayerPosition(const player_t *);
+void BarPlayerCountersAdd(BarPlayerCounters_t *, const BarPlayerCounters_t *);
 void BarPlayerInit();
 void BarPlayerDestroy();
+bool BarPlayerCheckFilter(const BarSettings_t *);
+void BarPlayerGraphCacheInit(BarPlayerGraphCache_t *);
+void BarPlayerGraphCacheDestroy(BarPlayerGraphCache_t *);
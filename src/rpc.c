@@ -0,0 +1,576 @@
+/*
+Copyright (c) 2026
+        pianobar contributors
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+
+/* asynchronous pandora api calls, driven by the main loop */
+
+#include "config.h"
+
+#include <assert.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "rpc.h"
+#include "ui.h"
+
+/*	parse the response while it is received
+ */
+static size_t fetchCb(char *ptr, size_t size, size_t nmemb, void *userdata) {
+    BarRpcCall_t *const call = userdata;
+    const size_t recvSize = size * nmemb;
+
+    PianoResponseFeed(&call->req, ptr, recvSize);
+
+    return recvSize;
+}
+
+/*	libcurl progress callback. aborts the transfer if the call was
+ *	interrupted, i.e. user pressed ^C
+ */
+static int progressCb(void *const data, curl_off_t dltotal, curl_off_t dlnow,
+                      curl_off_t ultotal, curl_off_t ulnow) {
+    const BarRpcCall_t *const call = data;
+    return call->interrupt != NULL && *call->interrupt != 0;
+}
+
+#define setAndCheck(k, v)                   \
+    httpret = curl_easy_setopt(http, k, v); \
+    assert(httpret == CURLE_OK);
+
+/*	Create a handle. Options that do not change between calls are set only
+ *	once, connections are kept alive by the multi handle and TLS sessions
+ *	are shared, i.e. resumed if the server closed the connection in between.
+ */
+static CURL *newHandle(BarRpc_t *const rpc) {
+    const BarSettings_t *const settings = rpc->settings;
+    CURLcode httpret;
+
+    CURL *const http = curl_easy_init();
+    if (http == NULL) {
+        return NULL;
+    }
+
+    if (rpc->share != NULL) {
+        setAndCheck(CURLOPT_SHARE, rpc->share);
+    }
+    setAndCheck(CURLOPT_USERAGENT, PACKAGE "-" VERSION);
+    setAndCheck(CURLOPT_WRITEFUNCTION, fetchCb);
+    setAndCheck(CURLOPT_XFERINFOFUNCTION, progressCb);
+    setAndCheck(CURLOPT_NOPROGRESS, 0);
+    setAndCheck(CURLOPT_POST, 1);
+    /* playlists are fetched every few minutes, keep idle connections open */
+    setAndCheck(CURLOPT_TCP_KEEPALIVE, 1L);
+    setAndCheck(CURLOPT_HTTPHEADER, rpc->headers);
+    if (settings->caBundle != NULL) {
+        setAndCheck(CURLOPT_CAINFO, settings->caBundle);
+    }
+
+    if (settings->bindTo != NULL) {
+        if (curl_easy_setopt(http, CURLOPT_INTERFACE, settings->bindTo) !=
+            CURLE_OK) {
+            /* if binding fails, notice about that */
+            BarUiMsg(settings, MSG_ERR, "bindTo (%s) is invalid!\n",
+                     settings->bindTo);
+        }
+    }
+
+    /* set up proxy (control proxy for non-us citizen or global proxy for
+     * poor firewalled fellows) */
+    if (settings->controlProxy != NULL) {
+        /* control proxy overrides global proxy */
+        if (curl_easy_setopt(http, CURLOPT_PROXY, settings->controlProxy) !=
+            CURLE_OK) {
+            /* if setting proxy fails, url is invalid */
+            BarUiMsg(settings, MSG_ERR, "Control proxy (%s) is invalid!\n",
+                     settings->controlProxy);
+        }
+    } else if (settings->proxy != NULL && strlen(settings->proxy) > 0) {
+        if (curl_easy_setopt(http, CURLOPT_PROXY, settings->proxy) !=
+            CURLE_OK) {
+            /* if setting proxy fails, url is invalid */
+            BarUiMsg(settings, MSG_ERR, "Proxy (%s) is invalid!\n",
+                     settings->proxy);
+        }
+    }
+
+    return http;
+}
+
+/*	take a handle from the idle list or create a new one
+ */
+static CURL *getHandle(BarRpc_t *const rpc) {
+    if (rpc->idleCount > 0) {
+        return rpc->idle[--rpc->idleCount];
+    }
+    return newHandle(rpc);
+}
+
+/*	return the call’s handle to the idle list
+ */
+static void releaseHandle(BarRpc_t *const rpc, BarRpcCall_t *const call) {
+    if (call->http == NULL) {
+        return;
+    }
+    if (call->state == BAR_RPC_RUNNING) {
+        curl_multi_remove_handle(rpc->multi, call->http);
+    }
+    if (rpc->idleCount < BAR_RPC_IDLE) {
+        rpc->idle[rpc->idleCount++] = call->http;
+    } else {
+        curl_easy_cleanup(call->http);
+    }
+    call->http = NULL;
+}
+
+/*	free data of the current request step
+ */
+static void destroyStep(BarRpcCall_t *const call) {
+    /* persistent data is stored in req.data */
+    PianoDestroyRequest(&call->req);
+}
+
+/*	result is available, callback is run by BarRpcPerform
+ */
+static void complete(BarRpc_t *const rpc, BarRpcCall_t *const call,
+                     const PianoReturn_t pRet, const CURLcode wRet) {
+    releaseHandle(rpc, call);
+    call->pRet = pRet;
+    call->wRet = wRet;
+    call->state = BAR_RPC_DONE;
+}
+
+/*	prepare next request step and start the transfer
+ */
+static void startCall(BarRpc_t *const rpc, BarRpcCall_t *const call) {
+    const BarSettings_t *const settings = rpc->settings;
+
+    if (rpc->reauth != NULL && call->type != PIANO_REQUEST_LOGIN) {
+        /* wait for the new token instead of using the one being replaced */
+        call->state = BAR_RPC_REAUTH;
+        return;
+    }
+
+    memset(&call->req, 0, sizeof(call->req));
+    call->req.data = call->data;
+    const PianoReturn_t pRet = PianoRequest(rpc->ph, &call->req, call->type);
+    if (pRet != PIANO_RET_OK) {
+        destroyStep(call);
+        complete(rpc, call, pRet, CURLE_OK);
+        return;
+    }
+
+    if (call->http == NULL && (call->http = getHandle(rpc)) == NULL) {
+        destroyStep(call);
+        complete(rpc, call, PIANO_RET_OK, CURLE_FAILED_INIT);
+        return;
+    }
+
+    char url[2048];
+    assert(settings->rpcHost != NULL);
+    assert(settings->rpcPort != NULL);
+    assert(settings->rpcTlsPort != NULL);
+    const int ret =
+        snprintf(url, sizeof(url), "%s://%s:%s%s",
+                 call->req.secure ? "https" : "http", settings->rpcHost,
+                 call->req.secure ? settings->rpcTlsPort : settings->rpcPort,
+                 call->req.urlPath);
+    assert(ret >= 0 && ret <= (int)sizeof(url));
+
+    /* everything else is set up by newHandle */
+    CURL *const http = call->http;
+    CURLcode httpret;
+    setAndCheck(CURLOPT_URL, url);
+    setAndCheck(CURLOPT_POSTFIELDS, call->req.postData);
+    setAndCheck(CURLOPT_WRITEDATA, call);
+    setAndCheck(CURLOPT_XFERINFODATA, call);
+    setAndCheck(CURLOPT_PRIVATE, call);
+
+    if (curl_multi_add_handle(rpc->multi, http) != CURLM_OK) {
+        destroyStep(call);
+        /* not added, nothing to remove */
+        call->state = BAR_RPC_DONE;
+        complete(rpc, call, PIANO_RET_OK, CURLE_FAILED_INIT);
+        return;
+    }
+    call->state = BAR_RPC_RUNNING;
+}
+
+/*	record whether the transfer reused a connection and how long
+ *	connecting took
+ */
+static void countStats(BarRpc_t *const rpc, CURL *const http) {
+    long connects = 0;
+    double connect = 0, appconnect = 0;
+
+    curl_easy_getinfo(http, CURLINFO_NUM_CONNECTS, &connects);
+    curl_easy_getinfo(http, CURLINFO_CONNECT_TIME, &connect);
+    curl_easy_getinfo(http, CURLINFO_APPCONNECT_TIME, &appconnect);
+
+    ++rpc->stats.requests;
+    if (connects == 0) {
+        ++rpc->stats.reused;
+        rpc->stats.lastHandshakeUs = 0;
+    } else {
+        /* tcp and, for https, tls handshake */
+        const double handshake = appconnect > connect ? appconnect : connect;
+        rpc->stats.lastHandshakeUs = handshake * 1000000;
+        rpc->stats.handshakeUs += rpc->stats.lastHandshakeUs;
+    }
+}
+
+static void reauthDone(BarRpcCall_t *, void *);
+
+/*	renew the auth token, unless this is in progress already
+ *	@param engine
+ *	@param interrupt, see BarRpcSubmit
+ *	@param quiet: only report failure
+ */
+static void startReauth(BarRpc_t *const rpc, sig_atomic_t *const interrupt,
+                        const bool quiet) {
+    if (rpc->reauth != NULL) {
+        return;
+    }
+
+    if (!quiet) {
+        BarUiMsg(rpc->settings, MSG_INFO, "Reauthentication required... ");
+    }
+    rpc->reauthQuiet = quiet;
+    rpc->login.user = rpc->settings->username;
+    rpc->login.password = rpc->settings->password;
+    rpc->login.step = 0;
+    rpc->reauth = BarRpcSubmit(rpc, PIANO_REQUEST_LOGIN, &rpc->login,
+                               interrupt, reauthDone, rpc);
+    if (rpc->reauth == NULL) {
+        for (BarRpcCall_t *call = rpc->calls; call != NULL; call = call->next) {
+            if (call->state == BAR_RPC_REAUTH) {
+                complete(rpc, call, PIANO_RET_OUT_OF_MEMORY, CURLE_OK);
+            }
+        }
+    }
+}
+
+/*	retry calls waiting for the new token or fail them
+ */
+static void reauthDone(BarRpcCall_t *const login, void *const data) {
+    BarRpc_t *const rpc = data;
+
+    rpc->reauth = NULL;
+    const bool ok = login->pRet == PIANO_RET_OK && login->wRet == CURLE_OK;
+    if (rpc->reauthQuiet && !ok) {
+        BarUiMsg(rpc->settings, MSG_INFO, "Reauthentication... ");
+    }
+    if (!rpc->reauthQuiet || !ok) {
+        BarUiPianoResult(rpc->settings, login->pRet, login->wRet);
+    }
+    for (BarRpcCall_t *call = rpc->calls; call != NULL; call = call->next) {
+        if (call->state != BAR_RPC_REAUTH) {
+            continue;
+        }
+        if (ok) {
+            if (call->reauthed) {
+                BarUiMsg(rpc->settings, MSG_INFO, "Trying again... ");
+            }
+            startCall(rpc, call);
+        } else {
+            complete(rpc, call, login->pRet, login->wRet);
+        }
+    }
+}
+
+/*	transfer of a request step finished
+ */
+static void transferDone(BarRpc_t *const rpc, BarRpcCall_t *const call,
+                         const CURLcode result) {
+    curl_multi_remove_handle(rpc->multi, call->http);
+
+    PianoReturn_t pRet = PIANO_RET_OK;
+    if (result == CURLE_OK) {
+        countStats(rpc, call->http);
+        pRet = PianoResponse(rpc->ph, &call->req);
+    }
+    destroyStep(call);
+    /* handle is not part of the multi handle any more */
+    call->state = BAR_RPC_DONE;
+
+    if (result != CURLE_OK) {
+        complete(rpc, call, pRet, result);
+    } else if (pRet == PIANO_RET_CONTINUE_REQUEST) {
+        startCall(rpc, call);
+    } else if (pRet == PIANO_RET_P_INVALID_AUTH_TOKEN &&
+               call->type != PIANO_REQUEST_LOGIN && !call->reauthed) {
+        /* checking for request type and retrying only once avoids infinite
+         * loops */
+        call->reauthed = true;
+        releaseHandle(rpc, call);
+        call->state = BAR_RPC_REAUTH;
+        startReauth(rpc, call->interrupt, false);
+    } else {
+        complete(rpc, call, pRet, CURLE_OK);
+    }
+}
+
+/*	remove call from the list and free it
+ */
+static void freeCall(BarRpc_t *const rpc, BarRpcCall_t *const call) {
+    BarRpcCall_t **prev = &rpc->calls;
+    while (*prev != call) {
+        assert(*prev != NULL);
+        prev = &(*prev)->next;
+    }
+    *prev = call->next;
+
+    releaseHandle(rpc, call);
+    destroyStep(call);
+    free(call);
+}
+
+/*	Run callbacks of completed calls. Callbacks may submit or cancel calls.
+ *	@param engine
+ *	@param only run the callback of this call and of reauthentication,
+ *		others stay completed until the next unrestricted dispatch, may
+ *		be NULL
+ */
+static void dispatch(BarRpc_t *const rpc, const BarRpcCall_t *const only) {
+    bool found;
+    do {
+        found = false;
+        for (BarRpcCall_t *call = rpc->calls; call != NULL;
+             call = call->next) {
+            if (call->state != BAR_RPC_DONE) {
+                continue;
+            }
+            if (only != NULL && call != only && call->done != reauthDone) {
+                continue;
+            }
+            const bool last = call == only;
+            call->done(call, call->cbData);
+            freeCall(rpc, call);
+            if (last) {
+                return;
+            }
+            found = true;
+            break;
+        }
+    } while (found);
+}
+
+/*	check for completed calls whose callback did not run yet
+ */
+static bool hasCompleted(const BarRpc_t *const rpc) {
+    for (const BarRpcCall_t *call = rpc->calls; call != NULL;
+         call = call->next) {
+        if (call->state == BAR_RPC_DONE) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/*	set up the engine
+ */
+void BarRpcInit(BarRpc_t *const rpc, PianoHandle_t *const ph,
+                const BarSettings_t *const settings) {
+    memset(rpc, 0, sizeof(*rpc));
+    rpc->ph = ph;
+    rpc->settings = settings;
+
+    rpc->multi = curl_multi_init();
+    assert(rpc->multi != NULL);
+
+    rpc->share = curl_share_init();
+    if (rpc->share != NULL) {
+        /* only used from the main thread, no locking required */
+        curl_share_setopt(rpc->share, CURLSHOPT_SHARE,
+                          CURL_LOCK_DATA_SSL_SESSION);
+        curl_share_setopt(rpc->share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+    }
+
+    rpc->headers = curl_slist_append(NULL, "Content-Type: text/plain");
+}
+
+/*	cancel all calls and free resources
+ */
+void BarRpcDestroy(BarRpc_t *const rpc) {
+    while (rpc->calls != NULL) {
+        BarRpcCancel(rpc, rpc->calls);
+    }
+    /* handles must be cleaned up before the share they are using */
+    for (size_t i = 0; i < rpc->idleCount; i++) {
+        curl_easy_cleanup(rpc->idle[i]);
+    }
+    rpc->idleCount = 0;
+    if (rpc->multi != NULL) {
+        curl_multi_cleanup(rpc->multi);
+        rpc->multi = NULL;
+    }
+    if (rpc->share != NULL) {
+        curl_share_cleanup(rpc->share);
+        rpc->share = NULL;
+    }
+    curl_slist_free_all(rpc->headers);
+    rpc->headers = NULL;
+}
+
+/*	Start a call. Multi-step requests and reauthentication on expired
+ *	tokens are handled transparently.
+ *	@param engine
+ *	@param request type
+ *	@param request data, must stay valid until completion
+ *	@param transfer is aborted if this becomes non-zero, may be NULL
+ *	@param completion callback, never called from this function
+ *	@param callback data
+ *	@return call, valid until completion or cancellation
+ */
+BarRpcCall_t *BarRpcSubmit(BarRpc_t *const rpc, const PianoRequestType_t type,
+                           void *const data, sig_atomic_t *const interrupt,
+                           const BarRpcDoneCb_t done, void *const cbData) {
+    assert(rpc != NULL);
+    assert(done != NULL);
+
+    BarRpcCall_t *const call = calloc(1, sizeof(*call));
+    if (call == NULL) {
+        return NULL;
+    }
+    call->type = type;
+    call->data = data;
+    call->interrupt = interrupt;
+    call->done = done;
+    call->cbData = cbData;
+
+    /* append, so callbacks run in submission order */
+    BarRpcCall_t **last = &rpc->calls;
+    while (*last != NULL) {
+        last = &(*last)->next;
+    }
+    *last = call;
+
+    startCall(rpc, call);
+
+    return call;
+}
+
+/*	abort call, its callback is not run
+ */
+void BarRpcCancel(BarRpc_t *const rpc, BarRpcCall_t *const call) {
+    if (call == NULL) {
+        return;
+    }
+    if (call == rpc->reauth) {
+        /* calls waiting for it would never finish */
+        rpc->reauth = NULL;
+        for (BarRpcCall_t *c = rpc->calls; c != NULL; c = c->next) {
+            if (c->state == BAR_RPC_REAUTH) {
+                complete(rpc, c, PIANO_RET_OK, CURLE_ABORTED_BY_CALLBACK);
+            }
+        }
+    }
+    freeCall(rpc, call);
+}
+
+/*	Renew the auth token in the background before it expires. Calls
+ *	submitted meanwhile wait for the new token.
+ */
+void BarRpcRefreshAuth(BarRpc_t *const rpc) {
+    startReauth(rpc, NULL, true);
+}
+
+/*	make progress on all transfers without blocking, then run callbacks of
+ *	completed calls
+ *	@param engine
+ *	@param only run this call’s callback, see dispatch, may be NULL
+ */
+void BarRpcPerform(BarRpc_t *const rpc, const BarRpcCall_t *const only) {
+    int running;
+    curl_multi_perform(rpc->multi, &running);
+
+    CURLMsg *msg;
+    int left;
+    while ((msg = curl_multi_info_read(rpc->multi, &left)) != NULL) {
+        if (msg->msg != CURLMSG_DONE) {
+            continue;
+        }
+        /* msg is invalid once the handle is removed */
+        const CURLcode result = msg->data.result;
+        BarRpcCall_t *call = NULL;
+        curl_easy_getinfo(msg->easy_handle, CURLINFO_PRIVATE, (char **)&call);
+        assert(call != NULL);
+        transferDone(rpc, call, result);
+    }
+
+    dispatch(rpc, only);
+}
+
+/*	wait for network activity or user input, then call BarRpcPerform
+ *	@param engine
+ *	@param input fds, may be NULL
+ *	@param timeout, milliseconds
+ *	@param only run the callback of this call, callbacks of other calls are
+ *		deferred to a later wait without restriction. Used for synchronous
+ *		calls, which must not run callbacks freeing data the caller is
+ *		using. May be NULL.
+ *	@return true if input is available
+ */
+bool BarRpcWait(BarRpc_t *const rpc, BarReadlineFds_t *const input,
+                int timeout, const BarRpcCall_t *const only) {
+    struct curl_waitfd extra[2];
+    unsigned int n = 0;
+
+    if (only == NULL && hasCompleted(rpc)) {
+        /* deferred by a synchronous call */
+        timeout = 0;
+    }
+
+    if (input != NULL) {
+        assert(sizeof(input->fds) / sizeof(*input->fds) == 2);
+        for (size_t i = 0; i < 2; i++) {
+            const int fd = input->fds[i];
+            if (fd != -1 && FD_ISSET(fd, &input->set)) {
+                extra[n].fd = fd;
+                extra[n].events = CURL_WAIT_POLLIN;
+                extra[n].revents = 0;
+                ++n;
+            }
+        }
+    }
+
+#if LIBCURL_VERSION_NUM >= 0x074200
+    curl_multi_poll(rpc->multi, extra, n, timeout, NULL);
+#else
+    if (n == 0 && rpc->calls == NULL) {
+        /* curl_multi_wait returns immediately without any fd */
+        poll(NULL, 0, timeout);
+    } else {
+        curl_multi_wait(rpc->multi, extra, n, timeout, NULL);
+    }
+#endif
+
+    BarRpcPerform(rpc, only);
+
+    for (unsigned int i = 0; i < n; i++) {
+        if (extra[i].revents != 0) {
+            return true;
+        }
+    }
+    return false;
+}
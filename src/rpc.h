@@ -0,0 +1,104 @@
+/*
+Copyright (c) 2026
+        pianobar contributors
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+
+#pragma once
+
+#include "config.h"
+
+#include <signal.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include <curl/curl.h>
+
+#include <piano.h>
+
+#include "settings.h"
+#include "ui_readline.h"
+
+/* configured curl handles kept for later calls */
+#define BAR_RPC_IDLE 4
+
+struct BarRpcCall;
+
+/* completion callback, called from the main loop or, for the call waited
+ * for, from a synchronous wait. The call is freed afterwards. */
+typedef void (*BarRpcDoneCb_t)(struct BarRpcCall *, void *);
+
+typedef struct BarRpcCall {
+    PianoRequestType_t type;
+    /* request data, must stay valid until the call completes */
+    void *data;
+    PianoRequest_t req;
+    CURL *http;
+    /* transfer is aborted as soon as this is non-zero, may be NULL */
+    sig_atomic_t *interrupt;
+    enum {
+        BAR_RPC_RUNNING,
+        /* waiting for reauthentication to finish */
+        BAR_RPC_REAUTH,
+        /* result available, callback pending */
+        BAR_RPC_DONE,
+    } state;
+    /* expired token was renewed once already */
+    bool reauthed;
+    PianoReturn_t pRet;
+    CURLcode wRet;
+    BarRpcDoneCb_t done;
+    void *cbData;
+    struct BarRpcCall *next;
+} BarRpcCall_t;
+
+typedef struct {
+    CURLM *multi;
+    /* tls sessions and dns cache of all handles */
+    CURLSH *share;
+    struct curl_slist *headers;
+    CURL *idle[BAR_RPC_IDLE];
+    size_t idleCount;
+    /* calls not completed yet */
+    BarRpcCall_t *calls;
+    /* login started because a token expired */
+    BarRpcCall_t *reauth;
+    /* started by BarRpcRefreshAuth, only failure is reported */
+    bool reauthQuiet;
+    PianoRequestDataLogin_t login;
+    PianoHandle_t *ph;
+    const BarSettings_t *settings;
+    struct {
+        unsigned int requests, reused;
+        /* time spent connecting, microseconds */
+        unsigned long long handshakeUs;
+        unsigned int lastHandshakeUs;
+    } stats;
+} BarRpc_t;
+
+void BarRpcInit(BarRpc_t *, PianoHandle_t *, const BarSettings_t *);
+void BarRpcDestroy(BarRpc_t *);
+BarRpcCall_t *BarRpcSubmit(BarRpc_t *, PianoRequestType_t, void *,
+                           sig_atomic_t *, BarRpcDoneCb_t, void *);
+void BarRpcCancel(BarRpc_t *, BarRpcCall_t *);
+void BarRpcPerform(BarRpc_t *, const BarRpcCall_t *);
+void BarRpcRefreshAuth(BarRpc_t *);
+bool BarRpcWait(BarRpc_t *, BarReadlineFds_t *, int, const BarRpcCall_t *);
@@ -0,0 +1,475 @@
+/*
+Copyright (c) 2026
+        pianobar contributors
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+
+/* least recently used cache of music search results, optionally kept in a
+ * file between runs. The file has one line per query or result:
+ *
+ *	q<tab>stored<tab>query
+ *	a<tab>score<tab>musicId<tab>name
+ *	s<tab>musicId<tab>artist<tab>title
+ */
+
+#include "config.h"
+
+#include <assert.h>
+#include <ctype.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "search.h"
+
+#define BAR_SEARCH_MAGIC "pianobar search 1\n"
+
+/*	lowercase and collapse whitespace, so "Daft  punk " and "daft punk" are
+ *	the same query
+ *	@return normalized query, must be freed, NULL if out of memory
+ */
+static char *BarSearchNormalize(const char *query) {
+    char *const norm = malloc(strlen(query) + 1);
+    if (norm == NULL) {
+        return NULL;
+    }
+    char *out = norm;
+
+    while (*query != '\0') {
+        if (isspace((unsigned char)*query)) {
+            while (isspace((unsigned char)*query)) {
+                ++query;
+            }
+            if (out != norm && *query != '\0') {
+                *out++ = ' ';
+            }
+        } else {
+            *out++ = tolower((unsigned char)*query++);
+        }
+    }
+    *out = '\0';
+
+    return norm;
+}
+
+/*	copy optional string
+ *	@return false if out of memory
+ */
+static bool BarSearchStrdup(char **const dest, const char *const s) {
+    *dest = s == NULL ? NULL : strdup(s);
+    return s == NULL || *dest != NULL;
+}
+
+static void BarSearchFreeArtist(PianoArtist_t *const a) {
+    free(a->name);
+    free(a->musicId);
+    free(a->seedId);
+    free(a);
+}
+
+/*	copy the fields of a search result BarUiSelectMusicId uses, results
+ *	that cannot be copied are left out
+ */
+static void BarSearchCopy(PianoSearchResult_t *const dest,
+                          const PianoSearchResult_t *const src) {
+    memset(dest, 0, sizeof(*dest));
+    PianoListHead_t *tail = NULL;
+
+    const PianoArtist_t *artist = src->artists;
+    PianoListForeachP(artist) {
+        PianoArtist_t *const a = calloc(1, sizeof(*a));
+        if (a == NULL) {
+            continue;
+        }
+        if (!BarSearchStrdup(&a->name, artist->name) ||
+            !BarSearchStrdup(&a->musicId, artist->musicId) ||
+            !BarSearchStrdup(&a->seedId, artist->seedId)) {
+            BarSearchFreeArtist(a);
+            continue;
+        }
+        a->score = artist->score;
+        dest->artists = PianoListAppendTailP(dest->artists, &tail, a);
+    }
+
+    tail = NULL;
+
+    const PianoSong_t *song = src->songs;
+    PianoListForeachP(song) {
+        PianoSong_t *const s = calloc(1, sizeof(*s));
+        if (s == NULL) {
+            continue;
+        }
+        if (!BarSearchStrdup(&s->artist, song->artist) ||
+            !BarSearchStrdup(&s->title, song->title) ||
+            !BarSearchStrdup(&s->musicId, song->musicId)) {
+            PianoDestroyPlaylist(s);
+            continue;
+        }
+        dest->songs = PianoListAppendTailP(dest->songs, &tail, s);
+    }
+}
+
+static void BarSearchUnlink(BarSearchCache_t *const cache,
+                            BarSearchEntry_t *const e) {
+    if (e->prev != NULL) {
+        e->prev->next = e->next;
+    } else {
+        cache->head = e->next;
+    }
+    if (e->next != NULL) {
+        e->next->prev = e->prev;
+    } else {
+        cache->tail = e->prev;
+    }
+    e->prev = e->next = NULL;
+    --cache->count;
+}
+
+static void BarSearchPushFront(BarSearchCache_t *const cache,
+                               BarSearchEntry_t *const e) {
+    e->prev = NULL;
+    e->next = cache->head;
+    if (cache->head != NULL) {
+        cache->head->prev = e;
+    } else {
+        cache->tail = e;
+    }
+    cache->head = e;
+    ++cache->count;
+}
+
+static void BarSearchFree(BarSearchEntry_t *const e) {
+    free(e->query);
+    PianoDestroySearchResult(&e->result);
+    free(e);
+}
+
+/*	drop least recently used entries until there is room for one more
+ */
+static void BarSearchEvict(BarSearchCache_t *const cache) {
+    while (cache->tail != NULL && cache->count >= cache->size) {
+        BarSearchEntry_t *const e = cache->tail;
+        BarSearchUnlink(cache, e);
+        BarSearchFree(e);
+    }
+}
+
+static bool BarSearchExpired(const BarSearchCache_t *const cache,
+                             const BarSearchEntry_t *const e,
+                             const time_t now) {
+    return e->stored > now || now - e->stored >= (time_t)cache->ttl;
+}
+
+/*	split tab separated line in place
+ *	@return number of fields
+ */
+static size_t BarSearchSplit(char *line, char **const fields,
+                             const size_t max) {
+    size_t n = 0;
+    while (n < max) {
+        fields[n++] = line;
+        /* the last field may contain tabs */
+        if (n == max || (line = strchr(line, '\t')) == NULL) {
+            break;
+        }
+        *line++ = '\0';
+    }
+    return n;
+}
+
+/*	read file written by BarSearchCacheSave, newest entry first
+ */
+static void BarSearchCacheLoad(BarSearchCache_t *const cache) {
+    FILE *const fp = fopen(cache->path, "r");
+    if (fp == NULL) {
+        return;
+    }
+
+    const time_t now = time(NULL);
+    BarSearchEntry_t *e = NULL;
+    PianoListHead_t *artistTail = NULL, *songTail = NULL;
+    char *line = NULL;
+    size_t size = 0;
+    ssize_t len;
+    bool valid = false;
+    while ((len = getline(&line, &size, fp)) != -1) {
+        if (!valid) {
+            valid = strcmp(line, BAR_SEARCH_MAGIC) == 0;
+            if (!valid) {
+                break;
+            }
+            continue;
+        }
+        if (len > 0 && line[len - 1] == '\n') {
+            line[len - 1] = '\0';
+        }
+
+        char *f[4];
+        const size_t n = BarSearchSplit(line, f, 4);
+        if (strcmp(f[0], "q") == 0 && n == 3) {
+            e = NULL;
+            artistTail = songTail = NULL;
+            if (cache->count >= cache->size) {
+                continue;
+            }
+            if ((e = calloc(1, sizeof(*e))) == NULL) {
+                /* results of this query are skipped */
+                continue;
+            }
+            if ((e->query = strdup(f[2])) == NULL) {
+                free(e);
+                e = NULL;
+                continue;
+            }
+            e->stored = atoll(f[1]);
+            if (BarSearchExpired(cache, e, now)) {
+                BarSearchFree(e);
+                e = NULL;
+                continue;
+            }
+            /* file is sorted by recency, append */
+            e->prev = cache->tail;
+            if (cache->tail != NULL) {
+                cache->tail->next = e;
+            } else {
+                cache->head = e;
+            }
+            cache->tail = e;
+            ++cache->count;
+        } else if (strcmp(f[0], "a") == 0 && n == 4 && e != NULL) {
+            PianoArtist_t *const a = calloc(1, sizeof(*a));
+            if (a == NULL) {
+                continue;
+            }
+            a->score = atoi(f[1]);
+            if (!BarSearchStrdup(&a->musicId, f[2]) ||
+                !BarSearchStrdup(&a->name, f[3])) {
+                BarSearchFreeArtist(a);
+                continue;
+            }
+            e->result.artists =
+                PianoListAppendTailP(e->result.artists, &artistTail, a);
+        } else if (strcmp(f[0], "s") == 0 && n == 4 && e != NULL) {
+            PianoSong_t *const s = calloc(1, sizeof(*s));
+            if (s == NULL) {
+                continue;
+            }
+            if (!BarSearchStrdup(&s->musicId, f[1]) ||
+                !BarSearchStrdup(&s->artist, f[2]) ||
+                !BarSearchStrdup(&s->title, f[3])) {
+                PianoDestroyPlaylist(s);
+                continue;
+            }
+            e->result.songs =
+                PianoListAppendTailP(e->result.songs, &songTail, s);
+        }
+    }
+    free(line);
+    fclose(fp);
+}
+
+static bool BarSearchWritable(const char *const s) {
+    return s != NULL && strpbrk(s, "\t\n") == NULL;
+}
+
+/*	write entries, readable by the current user only since queries are
+ *	personal
+ */
+static void BarSearchCacheSave(const BarSearchCache_t *const cache) {
+    const size_t pathLen = strlen(cache->path) + 5;
+    char *const tmpPath = malloc(pathLen);
+    if (tmpPath == NULL) {
+        return;
+    }
+    snprintf(tmpPath, pathLen, "%s.tmp", cache->path);
+
+    const int fd = open(tmpPath, O_WRONLY | O_CREAT | O_TRUNC, 0600);
+    FILE *fp;
+    if (fd == -1) {
+        free(tmpPath);
+        return;
+    }
+    if ((fp = fdopen(fd, "w")) == NULL) {
+        close(fd);
+        unlink(tmpPath);
+        free(tmpPath);
+        return;
+    }
+
+    fputs(BAR_SEARCH_MAGIC, fp);
+    for (const BarSearchEntry_t *e = cache->head; e != NULL; e = e->next) {
+        if (!BarSearchWritable(e->query)) {
+            continue;
+        }
+        fprintf(fp, "q\t%lld\t%s\n", (long long)e->stored, e->query);
+        const PianoArtist_t *artist = e->result.artists;
+        PianoListForeachP(artist) {
+            if (BarSearchWritable(artist->musicId) &&
+                BarSearchWritable(artist->name)) {
+                fprintf(fp, "a\t%i\t%s\t%s\n", artist->score, artist->musicId,
+                        artist->name);
+            }
+        }
+        const PianoSong_t *song = e->result.songs;
+        PianoListForeachP(song) {
+            if (BarSearchWritable(song->musicId) &&
+                BarSearchWritable(song->artist) &&
+                BarSearchWritable(song->title)) {
+                fprintf(fp, "s\t%s\t%s\t%s\n", song->musicId, song->artist,
+                        song->title);
+            }
+        }
+    }
+
+    const bool ok = !ferror(fp);
+    if (fclose(fp) == 0 && ok) {
+        rename(tmpPath, cache->path);
+    } else {
+        unlink(tmpPath);
+    }
+    free(tmpPath);
+}
+
+/*	set up cache
+ *	@param cache
+ *	@param maximum number of queries, 0 disables the cache
+ *	@param seconds until entries expire
+ *	@param file to keep entries in across runs, may be NULL
+ */
+void BarSearchCacheInit(BarSearchCache_t *const cache, const size_t size,
+                        const unsigned int ttl, const char *const path) {
+    assert(cache != NULL);
+
+    memset(cache, 0, sizeof(*cache));
+    cache->size = size;
+    cache->ttl = ttl;
+    if (path != NULL && size > 0 && ttl > 0) {
+        cache->path = strdup(path);
+        if (cache->path != NULL) {
+            BarSearchCacheLoad(cache);
+        }
+    }
+}
+
+/*	save and free all entries
+ */
+void BarSearchCacheDestroy(BarSearchCache_t *const cache) {
+    assert(cache != NULL);
+
+    if (cache->path != NULL) {
+        BarSearchCacheSave(cache);
+    }
+
+    BarSearchEntry_t *e = cache->head;
+    while (e != NULL) {
+        BarSearchEntry_t *const next = e->next;
+        BarSearchFree(e);
+        e = next;
+    }
+    free(cache->path);
+    memset(cache, 0, sizeof(*cache));
+}
+
+/*	look up query
+ *	@param cache
+ *	@param query as entered by the user
+ *	@param copy of the cached result, free with PianoDestroySearchResult
+ *	@return true on hit
+ */
+bool BarSearchCacheGet(BarSearchCache_t *const cache, const char *const query,
+                       PianoSearchResult_t *const result) {
+    assert(cache != NULL);
+    assert(query != NULL);
+    assert(result != NULL);
+
+    if (cache->size == 0 || cache->ttl == 0) {
+        return false;
+    }
+
+    char *const norm = BarSearchNormalize(query);
+    if (norm == NULL) {
+        ++cache->misses;
+        return false;
+    }
+    const time_t now = time(NULL);
+    BarSearchEntry_t *e = cache->head;
+    while (e != NULL && strcmp(e->query, norm) != 0) {
+        e = e->next;
+    }
+    free(norm);
+
+    if (e != NULL && BarSearchExpired(cache, e, now)) {
+        BarSearchUnlink(cache, e);
+        BarSearchFree(e);
+        e = NULL;
+    }
+    if (e == NULL) {
+        ++cache->misses;
+        return false;
+    }
+
+    ++cache->hits;
+    BarSearchUnlink(cache, e);
+    BarSearchPushFront(cache, e);
+    BarSearchCopy(result, &e->result);
+    return true;
+}
+
+/*	remember result of query
+ *	@param cache
+ *	@param query as entered by the user
+ *	@param result, copied
+ */
+void BarSearchCachePut(BarSearchCache_t *const cache, const char *const query,
+                       const PianoSearchResult_t *const result) {
+    assert(cache != NULL);
+    assert(query != NULL);
+    assert(result != NULL);
+
+    if (cache->size == 0 || cache->ttl == 0) {
+        return;
+    }
+
+    char *const norm = BarSearchNormalize(query);
+    if (norm == NULL) {
+        return;
+    }
+    BarSearchEntry_t *e = cache->head;
+    while (e != NULL && strcmp(e->query, norm) != 0) {
+        e = e->next;
+    }
+    if (e != NULL) {
+        BarSearchUnlink(cache, e);
+        BarSearchFree(e);
+    }
+
+    BarSearchEvict(cache);
+    if ((e = calloc(1, sizeof(*e))) == NULL) {
+        free(norm);
+        return;
+    }
+    e->query = norm;
+    e->stored = time(NULL);
+    BarSearchCopy(&e->result, result);
+    BarSearchPushFront(cache, e);
+}
@@ -0,0 +1,61 @@
+/*
+Copyright (c) 2026
+        pianobar contributors
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+
+#pragma once
+
+#include "config.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <time.h>
+
+#include <piano.h>
+
+typedef struct BarSearchEntry {
+    /* most recently used first */
+    struct BarSearchEntry *prev, *next;
+    /* normalized query */
+    char *query;
+    time_t stored;
+    PianoSearchResult_t result;
+} BarSearchEntry_t;
+
+/* recent search results, so repeated searches do not hit the network */
+typedef struct {
+    BarSearchEntry_t *head, *tail;
+    size_t count, size;
+    /* seconds, entries expire after that */
+    unsigned int ttl;
+    /* persisted across runs if not NULL */
+    char *path;
+    unsigned int hits, misses;
+} BarSearchCache_t;
+
+void BarSearchCacheInit(BarSearchCache_t *, size_t, unsigned int,
+                        const char *);
+void BarSearchCacheDestroy(BarSearchCache_t *);
+bool BarSearchCacheGet(BarSearchCache_t *, const char *,
+                       PianoSearchResult_t *);
+void BarSearchCachePut(BarSearchCache_t *, const char *,
+                       const PianoSearchResult_t *);
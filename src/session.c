@@ -0,0 +1,282 @@
+/*
+Copyright (c) 2026
+        pianobar contributors
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+
+/* auth tokens and station list of the last session, so the next start does
+ * not have to log in before playing music */
+
+#include "config.h"
+
+#include <assert.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "session.h"
+
+#define BAR_SESSION_VERSION 1
+
+/*	read one station line, id seedId flags name
+ *	@return station or NULL if the line is invalid
+ */
+static PianoStation_t *BarSessionParseStation(char *const line) {
+    char *save = NULL;
+    const char *const id = strtok_r(line, " ", &save);
+    const char *const seedId = strtok_r(NULL, " ", &save);
+    const char *const flags = strtok_r(NULL, " ", &save);
+    const char *const name = strtok_r(NULL, "", &save);
+
+    if (id == NULL || seedId == NULL || flags == NULL || name == NULL ||
+        strlen(flags) != 3) {
+        return NULL;
+    }
+
+    PianoStation_t *const s = calloc(1, sizeof(*s));
+    if (s == NULL) {
+        return NULL;
+    }
+    s->id = strdup(id);
+    s->seedId = strcmp(seedId, "-") == 0 ? NULL : strdup(seedId);
+    s->name = strdup(name);
+    if (s->id == NULL || s->name == NULL ||
+        (s->seedId == NULL && strcmp(seedId, "-") != 0)) {
+        PianoDestroyStations(s);
+        return NULL;
+    }
+    s->isCreator = flags[0] == '1';
+    s->isQuickMix = flags[1] == '1';
+    s->useQuickMix = flags[2] == '1';
+
+    return s;
+}
+
+/*	restore tokens and stations written by BarSessionSave. Nothing is
+ *	touched if the snapshot is missing, too old or belongs to another account.
+ *	@param piano handle, without user and stations
+ *	@param settings
+ *	@return true if the handle can be used right away
+ */
+bool BarSessionLoad(PianoHandle_t *const ph,
+                    const BarSettings_t *const settings) {
+    assert(ph != NULL);
+    assert(settings != NULL);
+
+    if (settings->sessionMaxAge == 0 || settings->username == NULL) {
+        return false;
+    }
+
+    const int fd = open(settings->sessionFile, O_RDONLY);
+    if (fd == -1) {
+        return false;
+    }
+    /* the tokens are as good as the password, so refuse a file someone else
+     * could have read or written */
+    struct stat st;
+    FILE *fp;
+    if (fstat(fd, &st) == -1 || st.st_uid != getuid() ||
+        (st.st_mode & (S_IRWXG | S_IRWXO)) != 0 ||
+        (fp = fdopen(fd, "r")) == NULL) {
+        close(fd);
+        return false;
+    }
+
+    int version = 0, partnerId = 0, timeOffset = 0;
+    long long savedAt = 0, authTime = 0;
+    bool sameUser = false, samePartner = false;
+    char *partnerToken = NULL, *userToken = NULL, *listenerId = NULL,
+         *checksum = NULL;
+    PianoStation_t *stations = NULL;
+    PianoListHead_t *tail = NULL;
+
+    char *line = NULL;
+    size_t size = 0;
+    ssize_t len;
+    while ((len = getline(&line, &size, fp)) != -1) {
+        if (len > 0 && line[len - 1] == '\n') {
+            line[len - 1] = '\0';
+        }
+        char *const val = strchr(line, ' ');
+        if (line[0] == '#' || val == NULL) {
+            continue;
+        }
+        *val = '\0';
+        const char *const key = line;
+        char *const v = val + 1;
+
+        if (strcmp(key, "version") == 0) {
+            version = atoi(v);
+        } else if (strcmp(key, "saved") == 0) {
+            savedAt = atoll(v);
+        } else if (strcmp(key, "user") == 0) {
+            sameUser = strcmp(v, settings->username) == 0;
+        } else if (strcmp(key, "partner") == 0) {
+            samePartner = strcmp(v, settings->partnerUser) == 0;
+        } else if (strcmp(key, "partner_id") == 0) {
+            partnerId = atoi(v);
+        } else if (strcmp(key, "partner_token") == 0) {
+            free(partnerToken);
+            partnerToken = strdup(v);
+        } else if (strcmp(key, "user_token") == 0) {
+            free(userToken);
+            userToken = strdup(v);
+        } else if (strcmp(key, "listener_id") == 0) {
+            free(listenerId);
+            listenerId = strdup(v);
+        } else if (strcmp(key, "stations_checksum") == 0) {
+            free(checksum);
+            checksum = strdup(v);
+        } else if (strcmp(key, "auth_time") == 0) {
+            authTime = atoll(v);
+        } else if (strcmp(key, "time_offset") == 0) {
+            timeOffset = atoi(v);
+        } else if (strcmp(key, "station") == 0) {
+            PianoStation_t *const s = BarSessionParseStation(v);
+            if (s != NULL) {
+                stations = PianoListAppendTailP(stations, &tail, s);
+            }
+        }
+    }
+    free(line);
+    fclose(fp);
+
+    const time_t now = time(NULL);
+    const bool valid = version == BAR_SESSION_VERSION && sameUser &&
+                       samePartner && partnerToken != NULL &&
+                       userToken != NULL && listenerId != NULL &&
+                       stations != NULL && savedAt <= now &&
+                       now - savedAt < (time_t)settings->sessionMaxAge;
+    if (!valid) {
+        free(partnerToken);
+        free(userToken);
+        free(listenerId);
+        free(checksum);
+        PianoDestroyStations(stations);
+        return false;
+    }
+
+    free(ph->partner.authToken);
+    ph->partner.authToken = partnerToken;
+    ph->partner.id = partnerId;
+    free(ph->user.authToken);
+    ph->user.authToken = userToken;
+    free(ph->user.listenerId);
+    ph->user.listenerId = listenerId;
+    ph->user.authTime = authTime;
+    ph->timeOffset = timeOffset;
+    assert(ph->stations == NULL);
+    ph->stations = stations;
+    PianoIndexStations(ph);
+    free(ph->stationsChecksum);
+    ph->stationsChecksum = checksum;
+
+    return true;
+}
+
+/*	check whether the station survives the line based format
+ */
+static bool BarSessionStorable(const PianoStation_t *const s) {
+    return s->id != NULL && s->name != NULL && strpbrk(s->id, " \n") == NULL &&
+           (s->seedId == NULL || strpbrk(s->seedId, " \n") == NULL) &&
+           strchr(s->name, '\n') == NULL;
+}
+
+/*	write tokens and stations, readable by the current user only
+ *	@param piano handle
+ *	@param settings
+ */
+void BarSessionSave(const PianoHandle_t *const ph,
+                    const BarSettings_t *const settings) {
+    assert(ph != NULL);
+    assert(settings != NULL);
+
+    if (settings->sessionMaxAge == 0 || settings->username == NULL ||
+        ph->user.authToken == NULL || ph->user.listenerId == NULL ||
+        ph->partner.authToken == NULL) {
+        return;
+    }
+
+    /* replace atomically, a crash must not leave half a file behind */
+    const size_t pathLen = strlen(settings->sessionFile) + 5;
+    char *const tmpPath = malloc(pathLen);
+    if (tmpPath == NULL) {
+        return;
+    }
+    snprintf(tmpPath, pathLen, "%s.tmp", settings->sessionFile);
+
+    const int fd = open(tmpPath, O_WRONLY | O_CREAT | O_TRUNC, 0600);
+    FILE *fp;
+    if (fd == -1) {
+        free(tmpPath);
+        return;
+    }
+    if ((fp = fdopen(fd, "w")) == NULL) {
+        close(fd);
+        unlink(tmpPath);
+        free(tmpPath);
+        return;
+    }
+
+    fputs("# do not edit this file\n", fp);
+    fprintf(fp, "version %i\n", BAR_SESSION_VERSION);
+    fprintf(fp, "saved %lld\n", (long long)time(NULL));
+    fprintf(fp, "user %s\n", settings->username);
+    fprintf(fp, "partner %s\n", settings->partnerUser);
+    fprintf(fp, "partner_id %u\n", ph->partner.id);
+    fprintf(fp, "partner_token %s\n", ph->partner.authToken);
+    fprintf(fp, "user_token %s\n", ph->user.authToken);
+    fprintf(fp, "listener_id %s\n", ph->user.listenerId);
+    fprintf(fp, "auth_time %lld\n", (long long)ph->user.authTime);
+    fprintf(fp, "time_offset %i\n", ph->timeOffset);
+    /* leave out stations that cannot be stored and the checksum, so the
+     * list is fetched again after restoring */
+    bool complete = true;
+    const PianoStation_t *s = ph->stations;
+    PianoListForeachP(s) {
+        complete = complete && BarSessionStorable(s);
+    }
+    if (ph->stationsChecksum != NULL && complete) {
+        fprintf(fp, "stations_checksum %s\n", ph->stationsChecksum);
+    }
+    s = ph->stations;
+    PianoListForeachP(s) {
+        if (!BarSessionStorable(s)) {
+            continue;
+        }
+        fprintf(fp, "station %s %s %c%c%c %s\n", s->id,
+                s->seedId != NULL ? s->seedId : "-", s->isCreator ? '1' : '0',
+                s->isQuickMix ? '1' : '0', s->useQuickMix ? '1' : '0',
+                s->name);
+    }
+
+    const bool ok = !ferror(fp);
+    if (fclose(fp) == 0 && ok) {
+        rename(tmpPath, settings->sessionFile);
+    } else {
+        unlink(tmpPath);
+    }
+    free(tmpPath);
+}
@@ -124,7 +124,16 @@ void BarSettingsDestroy(BarSettings_t *settings) {
   free(settings->npStationFormat);
   free(settings->listSongFormat);
   free(settings->fifo);
+  free(settings->pcmTap);
+  free(settings->sinks);
+  free(settings->audioFilter);
+  free(settings->loudnessDb);
+  free(settings->sessionFile);
+  free(settings->genreCache);
+  free(settings->searchCache);
+  free(settings->journalFile);
   free(settings->rpcHost);
+  free(settings->rpcPort);
   free(settings->rpcTlsPort);
   free(settings->partnerUser);
   free(settings->partnerPassword);
@@ -162,7 +171,21 @@ void BarSettingsRead(BarSettings_t *settings) {
   settings->save_dir = NULL;
   settings->volume = 0;
   settings->gainMul = 1.0;
+  settings->loudnessTarget = -18.0;
+  settings->silenceThreshold = -60;
+  settings->stallThresholdMs = 500;
   settings->maxPlayerErrors = 5;
+  settings->pcmTapMs = 500;
+  settings->sinks = strdup("ao");
+  settings->sinkQueue = 16;
+  settings->playlistPrefetch = 0;
+  settings->reauthInterval = 3600;
+  settings->sessionMaxAge = 86400;
+  settings->genreCacheTtl = 604800;
+  settings->searchCacheSize = 32;
+  settings->searchCacheTtl = 86400;
+  settings->audioPriority = 10;
+  settings->audioCpu = -1;
   settings->sortOrder = BAR_SORT_NAME_AZ;
   settings->loveIcon = strdup(" <3");
   settings->banIcon = strdup(" </3");
@@ -171,6 +194,7 @@ void BarSettingsRead(BarSettings_t *settings) {
   settings->npStationFormat = strdup("Station \"%n\" (%i)");
   settings->listSongFormat = strdup("%i) %a - %t%r");
   settings->rpcHost = strdup(PIANO_RPC_HOST);
+  settings->rpcPort = strdup("80");
   settings->rpcTlsPort = strdup("443");
   settings->partnerUser = strdup("android");
   settings->partnerPassword = strdup("AC7IBG09A3DTSYM4R41UJWL07VLN8JI7");
@@ -179,6 +203,14 @@ void BarSettingsRead(BarSettings_t *settings) {
   settings->outkey = strdup("6#26FRL$ZWD");
   settings->fifo = BarGetXdgConfigDir(PACKAGE "/ctl");
   assert(settings->fifo != NULL);
+  settings->loudnessDb = BarGetXdgConfigDir(PACKAGE "/loudness");
+  assert(settings->loudnessDb != NULL);
+  settings->sessionFile = BarGetXdgConfigDir(PACKAGE "/session");
+  assert(settings->sessionFile != NULL);
+  settings->genreCache = BarGetXdgConfigDir(PACKAGE "/genres");
+  assert(settings->genreCache != NULL);
+  settings->journalFile = BarGetXdgConfigDir(PACKAGE "/journal");
+  assert(settings->journalFile != NULL);
 
   settings->msgFormat[MSG_NONE].prefix = NULL;
   settings->msgFormat[MSG_NONE].postfix = NULL;
@@ -289,6 +321,9 @@ void BarSettingsRead(BarSettings_t *settings) {
       } else if (streq("rpc_host", key)) {
         free(settings->rpcHost);
         settings->rpcHost = strdup(val);
+      } else if (streq("rpc_port", key)) {
+        free(settings->rpcPort);
+        settings->rpcPort = strdup(val);
       } else if (streq("rpc_tls_port", key)) {
         free(settings->rpcTlsPort);
         settings->rpcTlsPort = strdup(val);
@@ -356,6 +391,19 @@ void BarSettingsRead(BarSettings_t *settings) {
             break;
           }
         }
+      } else if (streq("crossfade_ms", key)) {
+        settings->crossfadeMs = atoi(val);
+      } else if (streq("crossfade_curve", key)) {
+        static const char *mapping[] = {
+            "equalpower",
+            "linear",
+        };
+        for (size_t i = 0; i < BAR_CROSSFADE_COUNT; i++) {
+          if (streq(mapping[i], val)) {
+            settings->crossfadeCurve = i;
+            break;
+          }
+        }
       } else if (streq("love_icon", key)) {
         free(settings->loveIcon);
         settings->loveIcon = strdup(val);
@@ -381,6 +429,76 @@ void BarSettingsRead(BarSettings_t *settings) {
       } else if (streq("fifo", key)) {
         free(settings->fifo);
         settings->fifo = BarSettingsExpandTilde(val, userhome);
+      } else if (streq("pcm_tap", key)) {
+        free(settings->pcmTap);
+        settings->pcmTap = strdup(val);
+      } else if (streq("pcm_tap_ms", key)) {
+        settings->pcmTapMs = atoi(val);
+      } else if (streq("audio_filter", key)) {
+        free(settings->audioFilter);
+        settings->audioFilter = strdup(val);
+      } else if (streq("audio_sinks", key)) {
+        free(settings->sinks);
+        settings->sinks = strdup(val);
+      } else if (streq("audio_sink_queue", key)) {
+        settings->sinkQueue = atoi(val);
+      } else if (streq("audio_sched", key)) {
+        static const char *mapping[] = {
+            "other",
+            "fifo",
+            "rr",
+        };
+        for (size_t i = 0; i < BAR_SCHED_COUNT; i++) {
+          if (streq(mapping[i], val)) {
+            settings->audioSched = i;
+            break;
+          }
+        }
+      } else if (streq("audio_priority", key)) {
+        settings->audioPriority = atoi(val);
+      } else if (streq("audio_cpu", key)) {
+        settings->audioCpu = atoi(val);
+      } else if (streq("loudness_normalize", key)) {
+        settings->loudnessNormalize = atoi(val);
+      } else if (streq("loudness_target", key)) {
+        settings->loudnessTarget = atof(val);
+      } else if (streq("loudness_db", key)) {
+        free(settings->loudnessDb);
+        settings->loudnessDb = BarSettingsExpandTilde(val, userhome);
+      } else if (streq("silence_trim_ms", key)) {
+        settings->silenceTrimMs = atoi(val);
+      } else if (streq("silence_threshold", key)) {
+        settings->silenceThreshold = atoi(val);
+        /* dBFS, only levels below full scale make sense */
+        if (settings->silenceThreshold > -1) {
+          settings->silenceThreshold = -1;
+        }
+      } else if (streq("stall_threshold_ms", key)) {
+        settings->stallThresholdMs = atoi(val);
+      } else if (streq("genre_cache", key)) {
+        free(settings->genreCache);
+        settings->genreCache = BarSettingsExpandTilde(val, userhome);
+      } else if (streq("genre_cache_ttl", key)) {
+        settings->genreCacheTtl = atoi(val);
+      } else if (streq("journal_file", key)) {
+        free(settings->journalFile);
+        settings->journalFile = BarSettingsExpandTilde(val, userhome);
+      } else if (streq("search_cache", key)) {
+        free(settings->searchCache);
+        settings->searchCache = BarSettingsExpandTilde(val, userhome);
+      } else if (streq("search_cache_size", key)) {
+        settings->searchCacheSize = atoi(val);
+      } else if (streq("search_cache_ttl", key)) {
+        settings->searchCacheTtl = atoi(val);
+      } else if (streq("session_file", key)) {
+        free(settings->sessionFile);
+        settings->sessionFile = BarSettingsExpandTilde(val, userhome);
+      } else if (streq("session_max_age", key)) {
+        settings->sessionMaxAge = atoi(val);
+      } else if (streq("reauth_interval", key)) {
+        settings->reauthInterval = atoi(val);
+      } else if (streq("playlist_prefetch", key)) {
+        settings->playlistPrefetch = atoi(val);
       } else if (streq("autoselect", key)) {
         settings->autoselect = atoi(val);
       } else if (streq("save_dir", key)) {
@@ -59,8 +59,9 @@ typedef enum {
   BAR_KS_PAUSE = 27,
   BAR_KS_VOLRESET = 28,
   BAR_KS_SETTINGS = 29,
+  BAR_KS_STATS = 30,
   /* insert new shortcuts _before_ this element and increase its value */
-  BAR_KS_COUNT = 30,
+  BAR_KS_COUNT = 31,
 } BarKeyShortcutId_t;
 
 #define BAR_KS_DISABLED '\x00'
@@ -75,6 +76,19 @@ typedef enum {
   BAR_SORT_COUNT = 6,
 } BarStationSorting_t;
 
+typedef enum {
+  BAR_CROSSFADE_EQUALPOWER = 0,
+  BAR_CROSSFADE_LINEAR = 1,
+  BAR_CROSSFADE_COUNT = 2,
+} BarCrossfadeCurve_t;
+
+typedef enum {
+  BAR_SCHED_OTHER = 0,
+  BAR_SCHED_FIFO = 1,
+  BAR_SCHED_RR = 2,
+  BAR_SCHED_COUNT = 3,
+} BarSchedPolicy_t;
+
 typedef struct {
   char *prefix;
   char *postfix;
@@ -83,10 +97,18 @@ typedef struct {
 #include "ui_types.h"
 
 typedef struct {
-  bool autoselect;
-  unsigned int history, maxPlayerErrors;
+  bool autoselect, loudnessNormalize;
+  unsigned int history, maxPlayerErrors, pcmTapMs, sinkQueue;
   int volume;
-  float gainMul;
+  float gainMul, loudnessTarget;
+  unsigned int silenceTrimMs, crossfadeMs, stallThresholdMs;
+  unsigned int reauthInterval, sessionMaxAge, genreCacheTtl;
+  unsigned int searchCacheSize, searchCacheTtl;
+  BarCrossfadeCurve_t crossfadeCurve;
+  BarSchedPolicy_t audioSched;
+  int audioPriority, audioCpu;
+  int silenceThreshold;
+  int playlistPrefetch;
   BarStationSorting_t sortOrder;
   PianoAudioQuality_t audioQuality;
   char *username;
@@ -104,8 +126,16 @@ typedef struct {
   char *npStationFormat;
   char *listSongFormat;
   char *fifo;
-  char *rpcHost, *rpcTlsPort, *partnerUser, *partnerPassword, *device, *inkey,
-      *outkey, *caBundle;
+  char *pcmTap;
+  char *sinks;
+  char *audioFilter;
+  char *loudnessDb;
+  char *sessionFile;
+  char *genreCache;
+  char *searchCache;
+  char *journalFile;
+  char *rpcHost, *rpcPort, *rpcTlsPort, *partnerUser, *partnerPassword,
+      *device, *inkey, *outkey, *caBundle;
   char keys[BAR_KS_COUNT];
   BarMsgFormatStr_t msgFormat[MSG_COUNT];
 } BarSettings_t;
@@ -0,0 +1,1037 @@
+/*
+Copyright (c) 2026
+        pianobar contributors
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/* audio output sinks, every sink is fed by its own thread and queue */
+
+/* pthread_setaffinity_np() */
+#define _GNU_SOURCE
+
+#include "config.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <math.h>
+#include <netdb.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <libavutil/channel_layout.h>
+
+#include "sink.h"
+#include "ui.h"
+
+/* bytes per sample, the filter graph always outputs signed 16 bit */
+#define BAR_SINK_BPS 2
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+/*	write the whole buffer to a file descriptor
+ */
+static bool writeAll(const int fd, const char *data, size_t size) {
+    while (size > 0) {
+        const ssize_t ret = write(fd, data, size);
+        if (ret == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data += ret;
+        size -= ret;
+    }
+    return true;
+}
+
+/*	libao, the sound card
+ */
+static bool aoOpen(BarSink_t *const sink, const int rate, const int channels) {
+    ao_sample_format aoFmt;
+    memset(&aoFmt, 0, sizeof(aoFmt));
+    aoFmt.bits = BAR_SINK_BPS * 8;
+    aoFmt.channels = channels;
+    aoFmt.rate = rate;
+    aoFmt.byte_format = AO_FMT_NATIVE;
+
+    const int driver = sink->arg == NULL ? ao_default_driver_id()
+                                         : ao_driver_id(sink->arg);
+    if (driver < 0) {
+        return false;
+    }
+    return (sink->aoDev = ao_open_live(driver, &aoFmt, NULL)) != NULL;
+}
+
+static bool aoWrite(BarSink_t *const sink, const char *const data,
+                    const size_t size) {
+    if (ao_play(sink->aoDev, (char *)data, size) == 0) {
+        return false;
+    }
+    BarTapWrite(sink->tap, (const int16_t *)data,
+                size / (BAR_SINK_BPS * sink->channels), sink->channels,
+                sink->rate);
+    return true;
+}
+
+static void aoClose(BarSink_t *const sink) {
+    ao_close(sink->aoDev);
+    sink->aoDev = NULL;
+}
+
+/*	raw pcm appended to a file. The file has no header, so it keeps the
+ *	format of the first song and audio in any other format is dropped.
+ */
+static bool fileOpen(BarSink_t *const sink, const int rate,
+                     const int channels) {
+    if (sink->fileRate != 0 &&
+        (rate != sink->fileRate || channels != sink->fileChannels)) {
+        return false;
+    }
+    if ((sink->fp = fopen(sink->arg, "ab")) == NULL) {
+        return false;
+    }
+    sink->fileRate = rate;
+    sink->fileChannels = channels;
+    return true;
+}
+
+static bool fileWrite(BarSink_t *const sink, const char *const data,
+                      const size_t size) {
+    return fwrite(data, 1, size, sink->fp) == size;
+}
+
+static void fileClose(BarSink_t *const sink) {
+    fclose(sink->fp);
+    sink->fp = NULL;
+}
+
+/*	raw pcm written to a named pipe, only if someone is reading
+ */
+static bool fifoOpen(BarSink_t *const sink, const int rate,
+                     const int channels) {
+    /* fails with ENXIO if there is no reader, do not block */
+    if ((sink->fd = open(sink->arg, O_WRONLY | O_NONBLOCK)) == -1) {
+        return false;
+    }
+    /* the queue takes care of slow readers */
+    fcntl(sink->fd, F_SETFL, fcntl(sink->fd, F_GETFL) & ~O_NONBLOCK);
+    return true;
+}
+
+static bool fdWrite(BarSink_t *const sink, const char *const data,
+                    const size_t size) {
+    return writeAll(sink->fd, data, size);
+}
+
+static void fdClose(BarSink_t *const sink) {
+    close(sink->fd);
+    sink->fd = -1;
+}
+
+/*	raw pcm sent to a tcp server, host:port
+ */
+static bool tcpOpen(BarSink_t *const sink, const int rate, const int channels) {
+    char *const host = strdup(sink->arg);
+    if (host == NULL) {
+        return false;
+    }
+    char *const port = strrchr(host, ':');
+    if (port == NULL) {
+        free(host);
+        return false;
+    }
+    *port = '\0';
+
+    struct addrinfo hints, *res = NULL;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    if (getaddrinfo(host, port + 1, &hints, &res) != 0) {
+        free(host);
+        return false;
+    }
+    free(host);
+
+    sink->fd = -1;
+    for (struct addrinfo *ai = res; ai != NULL; ai = ai->ai_next) {
+        if ((sink->fd = socket(ai->ai_family, ai->ai_socktype,
+                               ai->ai_protocol)) == -1) {
+            continue;
+        }
+        if (connect(sink->fd, ai->ai_addr, ai->ai_addrlen) == 0) {
+            break;
+        }
+        close(sink->fd);
+        sink->fd = -1;
+    }
+    freeaddrinfo(res);
+
+    return sink->fd != -1;
+}
+
+/*	discard everything
+ */
+static bool nullOpen(BarSink_t *const sink, const int rate,
+                     const int channels) {
+    return true;
+}
+
+static bool nullWrite(BarSink_t *const sink, const char *const data,
+                      const size_t size) {
+    return true;
+}
+
+static void nullClose(BarSink_t *const sink) {}
+
+static const BarSinkOps_t sinkOps[] = {
+    {"ao", true, false, aoOpen, aoWrite, aoClose},
+    {"file", false, true, fileOpen, fileWrite, fileClose},
+    {"fifo", false, true, fifoOpen, fdWrite, fdClose},
+    {"tcp", false, true, tcpOpen, fdWrite, fdClose},
+    {"null", false, false, nullOpen, nullWrite, nullClose},
+};
+
+/*	drop all queued frames, sink must be locked
+ */
+static void BarSinkClear(BarSink_t *const sink) {
+    while (sink->count > 0) {
+        av_frame_free(&sink->queue[sink->head].frame);
+        sink->head = (sink->head + 1) % sink->size;
+        --sink->count;
+    }
+    pthread_cond_broadcast(&sink->notFull);
+}
+
+/*	sink thread, (re)opens the output whenever the format changes
+ */
+static void *BarSinkThread(void *data) {
+    BarSink_t *const sink = data;
+    /* do not hammer unavailable outputs, including the sound card */
+    time_t retryAt = 0;
+    /* a frame was played and the queue was not empty since */
+    bool playing = false;
+
+    pthread_mutex_lock(&sink->mutex);
+    while (true) {
+        if (sink->sinks != NULL && playing && sink->count == 0 &&
+            !sink->paused && !sink->quit &&
+            sink->song !=
+                __atomic_load_n(&sink->sinks->ended, __ATOMIC_ACQUIRE)) {
+            /* the song is not over, but there is nothing to play */
+            const uint64_t ms = sink->samples * 1000 / sink->rate;
+            __atomic_add_fetch(&sink->sinks->underruns, 1, __ATOMIC_RELAXED);
+            __atomic_store_n(&sink->sinks->lastUnderrun,
+                             (uint64_t)sink->song << 32 | (ms & UINT32_MAX),
+                             __ATOMIC_RELEASE);
+        }
+        playing = false;
+        while (!sink->quit && (sink->count == 0 || sink->paused)) {
+            pthread_cond_wait(&sink->notEmpty, &sink->mutex);
+        }
+        if (sink->quit) {
+            break;
+        }
+
+        AVFrame *frame = sink->queue[sink->head].frame;
+        const uint32_t song = sink->queue[sink->head].song;
+        sink->queue[sink->head].frame = NULL;
+        sink->head = (sink->head + 1) % sink->size;
+        --sink->count;
+        pthread_cond_broadcast(&sink->notFull);
+        pthread_mutex_unlock(&sink->mutex);
+
+        const int channels =
+            av_get_channel_layout_nb_channels(frame->channel_layout);
+        const int rate = frame->sample_rate;
+        if (sink->isOpen &&
+            (rate != sink->rate || channels != sink->channels)) {
+            sink->ops->close(sink);
+            sink->isOpen = false;
+        }
+        if (!sink->isOpen) {
+            if (time(NULL) >= retryAt) {
+                sink->isOpen = sink->ops->open(sink, rate, channels);
+                if (sink->isOpen) {
+                    sink->rate = rate;
+                    sink->channels = channels;
+                } else {
+                    retryAt = time(NULL) + 1;
+                }
+            }
+            /* also while waiting, the device sink must not run unpaced */
+            sink->failed = !sink->isOpen;
+        }
+        if (sink->isOpen &&
+            !sink->ops->write(sink, (const char *)frame->data[0],
+                              frame->nb_samples * channels * BAR_SINK_BPS)) {
+            /* reader went away, try again later */
+            sink->ops->close(sink);
+            sink->isOpen = false;
+            retryAt = time(NULL) + 1;
+        } else if (sink->sinks != NULL && sink->isOpen) {
+            /* the device has consumed these samples */
+            if (song != sink->song) {
+                sink->song = song;
+                sink->samples = 0;
+            }
+            sink->samples += frame->nb_samples;
+            const uint64_t ms = sink->samples * 1000 / rate;
+            __atomic_store_n(&sink->sinks->position,
+                             (uint64_t)song << 32 | (ms & UINT32_MAX),
+                             __ATOMIC_RELEASE);
+            playing = true;
+        }
+        av_frame_free(&frame);
+
+        pthread_mutex_lock(&sink->mutex);
+    }
+    pthread_mutex_unlock(&sink->mutex);
+
+    if (sink->isOpen) {
+        sink->ops->close(sink);
+        sink->isOpen = false;
+    }
+
+    return NULL;
+}
+
+/*	Run the device sink with the configured scheduling policy and CPU
+ *	affinity. Failures (usually missing permissions) are reported and the
+ *	thread keeps running with the defaults.
+ */
+static void BarSinkSetScheduling(BarSink_t *const sink,
+                                 const BarSettings_t *const settings) {
+    static const int policies[] = {SCHED_OTHER, SCHED_FIFO, SCHED_RR};
+    static const char *names[] = {"other", "fifo", "rr"};
+    int ret;
+
+    if (settings->audioSched == BAR_SCHED_OTHER && settings->audioCpu < 0) {
+        return;
+    }
+
+    if (settings->audioSched != BAR_SCHED_OTHER) {
+        const int policy = policies[settings->audioSched];
+        const int min = sched_get_priority_min(policy);
+        const int max = sched_get_priority_max(policy);
+        struct sched_param param;
+        memset(&param, 0, sizeof(param));
+        param.sched_priority = settings->audioPriority < min
+                                   ? min
+                                   : (settings->audioPriority > max
+                                          ? max
+                                          : settings->audioPriority);
+        if ((ret = pthread_setschedparam(sink->thread, policy, &param)) !=
+            0) {
+            BarUiMsg(settings, MSG_ERR,
+                     "Cannot change audio output scheduling (%s).\n",
+                     strerror(ret));
+        }
+    }
+
+    bool pinned = false;
+    if (settings->audioCpu >= 0) {
+#ifdef __linux__
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(settings->audioCpu, &set);
+        if ((ret = pthread_setaffinity_np(sink->thread, sizeof(set), &set)) !=
+            0) {
+            BarUiMsg(settings, MSG_ERR,
+                     "Cannot pin audio output to CPU %i (%s).\n",
+                     settings->audioCpu, strerror(ret));
+        } else {
+            pinned = true;
+        }
+#else
+        BarUiMsg(settings, MSG_ERR,
+                 "Pinning threads is not supported on this platform.\n");
+#endif
+    }
+
+    /* report what is actually in effect */
+    int policy;
+    struct sched_param param;
+    if (pthread_getschedparam(sink->thread, &policy, &param) == 0) {
+        const char *name = names[0];
+        for (size_t i = 0; i < sizeof(policies) / sizeof(*policies); i++) {
+            if (policies[i] == policy) {
+                name = names[i];
+            }
+        }
+        if (pinned) {
+            BarUiMsg(settings, MSG_INFO,
+                     "Audio output scheduling: %s, priority %i, CPU %i\n",
+                     name, param.sched_priority, settings->audioCpu);
+        } else {
+            BarUiMsg(settings, MSG_INFO,
+                     "Audio output scheduling: %s, priority %i, any CPU\n",
+                     name, param.sched_priority);
+        }
+    }
+}
+
+/*	set up sinks from the audio_sinks setting (type[:arg],...)
+ *	@return false if no sink could be created
+ */
+bool BarSinksInit(BarSinks_t *const sinks, const BarSettings_t *const settings,
+                  BarTap_t *const tap) {
+    assert(sinks != NULL);
+    assert(settings != NULL);
+    assert(settings->sinks != NULL);
+
+    memset(sinks, 0, sizeof(*sinks));
+    pthread_mutex_init(&sinks->mixer.mutex, NULL);
+    pthread_cond_init(&sinks->mixer.cond, NULL);
+
+    char *const spec = strdup(settings->sinks);
+    if (spec == NULL) {
+        return false;
+    }
+    /* sink threads point into the array, allocate it only once */
+    size_t maxSinks = 1;
+    for (const char *c = spec; *c != '\0'; c++) {
+        maxSinks += *c == ',';
+    }
+    if ((sinks->sink = calloc(maxSinks, sizeof(*sinks->sink))) == NULL) {
+        free(spec);
+        return false;
+    }
+
+    char *saveptr = NULL;
+    for (char *tok = strtok_r(spec, ",", &saveptr); tok != NULL;
+         tok = strtok_r(NULL, ",", &saveptr)) {
+        char *arg = strchr(tok, ':');
+        if (arg != NULL) {
+            *arg = '\0';
+            ++arg;
+        }
+
+        const BarSinkOps_t *ops = NULL;
+        for (size_t i = 0; i < sizeof(sinkOps) / sizeof(*sinkOps); i++) {
+            if (strcmp(sinkOps[i].name, tok) == 0) {
+                ops = &sinkOps[i];
+                break;
+            }
+        }
+        if (ops == NULL || (arg == NULL && ops->needsArg)) {
+            BarUiMsg(settings, MSG_ERR, "Invalid audio sink %s\n", tok);
+            continue;
+        }
+
+        BarSink_t *const sink = &sinks->sink[sinks->count];
+        sink->ops = ops;
+        sink->arg = arg == NULL ? NULL : strdup(arg);
+        sink->size = settings->sinkQueue > 0 ? settings->sinkQueue : 1;
+        sink->queue = calloc(sink->size, sizeof(*sink->queue));
+        if ((arg != NULL && sink->arg == NULL) || sink->queue == NULL) {
+            BarUiMsg(settings, MSG_ERR, "Out of memory for audio sink %s\n",
+                     tok);
+            free(sink->arg);
+            free(sink->queue);
+            memset(sink, 0, sizeof(*sink));
+            continue;
+        }
+        sink->settings = settings;
+        sink->fd = -1;
+        /* only what actually reaches the sound card is tapped */
+        sink->tap = ops->blocking ? tap : NULL;
+        sink->sinks = ops->blocking ? sinks : NULL;
+        pthread_mutex_init(&sink->mutex, NULL);
+        pthread_cond_init(&sink->notEmpty, NULL);
+        pthread_cond_init(&sink->notFull, NULL);
+        if (pthread_create(&sink->thread, NULL, BarSinkThread, sink) != 0) {
+            BarUiMsg(settings, MSG_ERR, "Cannot start audio sink %s\n", tok);
+            pthread_cond_destroy(&sink->notFull);
+            pthread_cond_destroy(&sink->notEmpty);
+            pthread_mutex_destroy(&sink->mutex);
+            free(sink->arg);
+            free(sink->queue);
+            memset(sink, 0, sizeof(*sink));
+            continue;
+        }
+        if (ops->blocking) {
+            BarSinkSetScheduling(sink, settings);
+            sinks->device = true;
+        }
+        ++sinks->count;
+    }
+    free(spec);
+
+    return sinks->count > 0;
+}
+
+/*	stop all sink threads, queued frames are discarded
+ */
+void BarSinksDestroy(BarSinks_t *const sinks) {
+    for (size_t i = 0; i < sinks->count; i++) {
+        BarSink_t *const sink = &sinks->sink[i];
+
+        pthread_mutex_lock(&sink->mutex);
+        sink->quit = true;
+        BarSinkClear(sink);
+        pthread_cond_broadcast(&sink->notEmpty);
+        pthread_mutex_unlock(&sink->mutex);
+        pthread_join(sink->thread, NULL);
+
+        pthread_cond_destroy(&sink->notFull);
+        pthread_cond_destroy(&sink->notEmpty);
+        pthread_mutex_destroy(&sink->mutex);
+        free(sink->queue);
+        free(sink->arg);
+    }
+    free(sinks->sink);
+    free(sinks->mixer.buf);
+    pthread_cond_destroy(&sinks->mixer.cond);
+    pthread_mutex_destroy(&sinks->mixer.mutex);
+    memset(sinks, 0, sizeof(*sinks));
+}
+
+/*	wait on cond for at most 100 ms
+ */
+static void BarSinksWait(pthread_cond_t *const cond,
+                         pthread_mutex_t *const mutex) {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    ts.tv_nsec += 100 * 1000 * 1000;
+    if (ts.tv_nsec >= 1000 * 1000 * 1000) {
+        ts.tv_nsec -= 1000 * 1000 * 1000;
+        ++ts.tv_sec;
+    }
+    pthread_cond_timedwait(cond, mutex, &ts);
+}
+
+/*	Hand a frame to every sink. Sinks share the frame’s buffers. Blocking
+ *	sinks make the caller wait for free space (until *abort is set), others
+ *	drop their oldest frame instead.
+ */
+static bool BarSinksQueue(BarSinks_t *const sinks, const AVFrame *const frame,
+                          const uint32_t song, volatile bool *const abort) {
+    bool ret = true;
+
+    for (size_t i = 0; i < sinks->count; i++) {
+        BarSink_t *const sink = &sinks->sink[i];
+
+        pthread_mutex_lock(&sink->mutex);
+        if (sink->ops->blocking) {
+            while (sink->count == sink->size && !*abort) {
+                BarSinksWait(&sink->notFull, &sink->mutex);
+            }
+        }
+        if (sink->count == sink->size && sink->ops->blocking) {
+            /* aborted */
+            pthread_mutex_unlock(&sink->mutex);
+            continue;
+        }
+        AVFrame *const copy = av_frame_clone(frame);
+        if (copy == NULL) {
+            /* out of memory, the sink misses this frame */
+            ++sink->dropped;
+            pthread_mutex_unlock(&sink->mutex);
+            continue;
+        }
+        if (sink->count == sink->size) {
+            av_frame_free(&sink->queue[sink->head].frame);
+            sink->head = (sink->head + 1) % sink->size;
+            --sink->count;
+            ++sink->dropped;
+        }
+        BarSinkItem_t *const item =
+            &sink->queue[(sink->head + sink->count) % sink->size];
+        item->frame = copy;
+        item->song = song;
+        ++sink->count;
+        pthread_cond_signal(&sink->notEmpty);
+        pthread_mutex_unlock(&sink->mutex);
+
+        if (sink->ops->blocking && sink->failed) {
+            ret = false;
+        }
+    }
+
+    return ret;
+}
+
+/*	gain of sample at position x (0 to 1) within the fade region
+ */
+static double fadeGain(const BarCrossfadeCurve_t curve, const double x,
+                       const bool in) {
+    if (x >= 1.0) {
+        return in ? 1.0 : 0.0;
+    }
+    switch (curve) {
+        case BAR_CROSSFADE_LINEAR:
+            return in ? x : 1.0 - x;
+
+        default:
+            /* constant power */
+            return in ? sin(x * M_PI / 2) : cos(x * M_PI / 2);
+    }
+}
+
+static int16_t clip(const double v) {
+    return v > INT16_MAX ? INT16_MAX : (v < INT16_MIN ? INT16_MIN : v);
+}
+
+static bool mixerCompatible(const BarSinkMixer_t *const m,
+                            const AVFrame *const frame) {
+    return frame->sample_rate == m->rate &&
+           frame->channel_layout == m->channelLayout;
+}
+
+/*	allocate frame in the mixer’s format
+ */
+static AVFrame *mixerFrame(const BarSinkMixer_t *const m,
+                           const size_t samples) {
+    AVFrame *frame = av_frame_alloc();
+    if (frame == NULL) {
+        return NULL;
+    }
+    frame->format = AV_SAMPLE_FMT_S16;
+    frame->channel_layout = m->channelLayout;
+    frame->sample_rate = m->rate;
+    frame->nb_samples = samples;
+    if (av_frame_get_buffer(frame, 0) < 0) {
+        av_frame_free(&frame);
+    }
+    return frame;
+}
+
+/*	fade in n samples of the incoming song, mixer must be locked
+ */
+static void mixerFadeIn(BarSinkMixer_t *const m, const int16_t *const src,
+                        int16_t *const dst, const size_t n,
+                        const int channels) {
+    for (size_t i = 0; i < n; i++) {
+        const double g =
+            fadeGain(m->curve, (double)m->inPos / m->length, true);
+        for (int c = 0; c < channels; c++) {
+            dst[i * channels + c] = clip(src[i * channels + c] * g);
+        }
+        ++m->inPos;
+    }
+}
+
+/*	take all buffered audio of the incoming song, mixer must be locked
+ *	@return frame or NULL
+ */
+static AVFrame *mixerTake(BarSinkMixer_t *const m) {
+    const int channels = av_get_channel_layout_nb_channels(m->channelLayout);
+    if (m->count == 0 || channels <= 0) {
+        return NULL;
+    }
+
+    AVFrame *const frame = mixerFrame(m, m->count / channels);
+    if (frame != NULL) {
+        int16_t *const dst = (int16_t *)frame->data[0];
+        const size_t first =
+            m->count < m->size - m->head ? m->count : m->size - m->head;
+        mixerFadeIn(m, &m->buf[m->head], dst, first / channels, channels);
+        mixerFadeIn(m, m->buf, dst + first, (m->count - first) / channels,
+                    channels);
+    }
+    m->head = 0;
+    m->count = 0;
+    return frame;
+}
+
+/*	crossfade is over, continue with the incoming song
+ */
+static void mixerReset(BarSinkMixer_t *const m, const uint32_t song,
+                       const uint64_t samples) {
+    m->out = 0;
+    m->in = 0;
+    m->song = song;
+    m->samples = samples;
+    m->head = 0;
+    m->count = 0;
+    pthread_cond_broadcast(&m->cond);
+}
+
+/*	mix a frame of the outgoing song with buffered audio of the incoming
+ *	one, expects the mixer to be locked
+ */
+static bool mixOut(BarSinks_t *const sinks, const AVFrame *const frame,
+                   volatile bool *const abort) {
+    BarSinkMixer_t *const m = &sinks->mixer;
+    const uint32_t song = m->out;
+    const uint64_t pos = m->outPos;
+    const size_t n = frame->nb_samples;
+    const int channels = av_get_channel_layout_nb_channels(m->channelLayout);
+
+    m->outPos += n;
+    if (m->outDone) {
+        /* faded out completely */
+        pthread_mutex_unlock(&m->mutex);
+        return true;
+    }
+    if (pos + n <= m->start || !mixerCompatible(m, frame)) {
+        pthread_mutex_unlock(&m->mutex);
+        return BarSinksQueue(sinks, frame, song, abort);
+    }
+
+    AVFrame *mixed = mixerFrame(m, n);
+    if (mixed == NULL) {
+        pthread_mutex_unlock(&m->mutex);
+        return BarSinksQueue(sinks, frame, song, abort);
+    }
+    const int16_t *const src = (const int16_t *)frame->data[0];
+    int16_t *const dst = (int16_t *)mixed->data[0];
+    for (size_t i = 0; i < n; i++) {
+        const uint64_t p = pos + i;
+        double gOut = 1.0, gIn = 0.0;
+        const int16_t *in = NULL;
+        if (p >= m->start) {
+            gOut = fadeGain(m->curve, (double)(p - m->start) / m->length,
+                            false);
+            /* the incoming song is delayed if it could not keep up */
+            if (m->count >= (size_t)channels) {
+                in = &m->buf[m->head];
+                gIn = fadeGain(m->curve, (double)m->inPos / m->length, true);
+                m->head = (m->head + channels) % m->size;
+                m->count -= channels;
+                ++m->inPos;
+            }
+        }
+        for (int c = 0; c < channels; c++) {
+            const double v =
+                src[i * channels + c] * gOut + (in != NULL ? in[c] * gIn : 0);
+            dst[i * channels + c] = clip(v);
+        }
+    }
+
+    AVFrame *pending = NULL;
+    const uint32_t in = m->in;
+    if (m->outPos >= m->start + m->length) {
+        m->outDone = true;
+        m->faded = song;
+        if (m->inDone) {
+            pending = mixerTake(m);
+            mixerReset(m, in, m->inTotal);
+        }
+    }
+    /* there is space in the buffer now */
+    pthread_cond_broadcast(&m->cond);
+    pthread_mutex_unlock(&m->mutex);
+
+    bool ret = BarSinksQueue(sinks, mixed, song, abort);
+    av_frame_free(&mixed);
+    if (pending != NULL) {
+        BarSinksQueue(sinks, pending, in, abort);
+        av_frame_free(&pending);
+    }
+    return ret;
+}
+
+/*	Buffer a frame of the incoming song until the outgoing song is faded
+ *	out, expects the mixer to be locked.
+ */
+static bool mixIn(BarSinks_t *const sinks, const AVFrame *const frame,
+                  volatile bool *const abort) {
+    BarSinkMixer_t *const m = &sinks->mixer;
+    const uint32_t song = m->in;
+    const int channels = av_get_channel_layout_nb_channels(m->channelLayout);
+    const size_t samples = frame->nb_samples * channels;
+    const bool compatible = mixerCompatible(m, frame) && samples <= m->size;
+
+    m->inTotal += frame->nb_samples;
+    while (!m->outDone && !*abort &&
+           (!compatible || m->size - m->count < samples)) {
+        BarSinksWait(&m->cond, &m->mutex);
+    }
+    if (*abort) {
+        pthread_mutex_unlock(&m->mutex);
+        return true;
+    }
+
+    if (!m->outDone) {
+        const size_t tail = (m->head + m->count) % m->size;
+        const size_t first =
+            samples < m->size - tail ? samples : m->size - tail;
+        const int16_t *const src = (const int16_t *)frame->data[0];
+        memcpy(&m->buf[tail], src, first * sizeof(*src));
+        memcpy(m->buf, src + first, (samples - first) * sizeof(*src));
+        m->count += samples;
+        pthread_mutex_unlock(&m->mutex);
+        return true;
+    }
+
+    /* outgoing song is done: buffered audio first, then this frame */
+    AVFrame *pending = mixerTake(m);
+    AVFrame *faded = NULL;
+    if (compatible && m->inPos < m->length) {
+        faded = mixerFrame(m, frame->nb_samples);
+        if (faded != NULL) {
+            mixerFadeIn(m, (const int16_t *)frame->data[0],
+                        (int16_t *)faded->data[0], frame->nb_samples,
+                        channels);
+        }
+    }
+    if (!compatible || m->inPos >= m->length) {
+        mixerReset(m, song, m->inTotal);
+    }
+    pthread_mutex_unlock(&m->mutex);
+
+    bool ret = true;
+    if (pending != NULL) {
+        ret = BarSinksQueue(sinks, pending, song, abort);
+        av_frame_free(&pending);
+    }
+    if (faded != NULL) {
+        ret = BarSinksQueue(sinks, faded, song, abort) && ret;
+        av_frame_free(&faded);
+    } else {
+        ret = BarSinksQueue(sinks, frame, song, abort) && ret;
+    }
+    return ret;
+}
+
+/*	Hand a frame to the sinks, mixing it with another song during a
+ *	crossfade.
+ *	@param sinks
+ *	@param frame
+ *	@param song id, see BarSinksNewSong
+ *	@param abort waiting if set
+ *	@return false if the device sink is not usable
+ */
+bool BarSinksWrite(BarSinks_t *const sinks, const AVFrame *const frame,
+                   const uint32_t song, volatile bool *const abort) {
+    BarSinkMixer_t *const m = &sinks->mixer;
+
+    pthread_mutex_lock(&m->mutex);
+    if (m->in != 0 && song == m->in) {
+        return mixIn(sinks, frame, abort);
+    } else if (m->out != 0 && song == m->out) {
+        return mixOut(sinks, frame, abort);
+    } else if (song == m->faded) {
+        /* longer than expected, but we moved on already */
+        pthread_mutex_unlock(&m->mutex);
+        return true;
+    }
+
+    if (song != m->song) {
+        m->song = song;
+        m->samples = 0;
+    }
+    m->samples += frame->nb_samples;
+    m->rate = frame->sample_rate;
+    m->channelLayout = frame->channel_layout;
+    pthread_mutex_unlock(&m->mutex);
+
+    return BarSinksQueue(sinks, frame, song, abort);
+}
+
+/*	Start fading from song out to song in. Audio of in is buffered until
+ *	out reaches the fade region.
+ *	@param sinks
+ *	@param outgoing song, must be playing
+ *	@param incoming song
+ *	@param start of the fade region within out, milliseconds
+ *	@param length of the fade region, milliseconds
+ *	@param fade curve
+ *	@return false if a crossfade is not possible right now
+ */
+bool BarSinksCrossfade(BarSinks_t *const sinks, const uint32_t out,
+                       const uint32_t in, const unsigned int startMs,
+                       const unsigned int lengthMs,
+                       const BarCrossfadeCurve_t curve) {
+    BarSinkMixer_t *const m = &sinks->mixer;
+    bool ret = false;
+
+    pthread_mutex_lock(&m->mutex);
+    const int channels = av_get_channel_layout_nb_channels(m->channelLayout);
+    if (m->out == 0 && m->song == out && m->rate > 0 && channels > 0) {
+        m->out = out;
+        m->in = in;
+        m->outDone = false;
+        m->inDone = false;
+        m->curve = curve;
+        m->outPos = m->samples;
+        m->start = (uint64_t)startMs * m->rate / 1000;
+        if (m->start < m->outPos) {
+            m->start = m->outPos;
+        }
+        m->length = (uint64_t)lengthMs * m->rate / 1000;
+        if (m->length == 0) {
+            m->length = 1;
+        }
+        m->inPos = 0;
+        m->inTotal = 0;
+        /* everything up to the end of the fade plus one second */
+        m->size = (m->start + m->length - m->outPos + m->rate) * channels;
+        free(m->buf);
+        m->buf = malloc(m->size * sizeof(*m->buf));
+        m->head = 0;
+        m->count = 0;
+        if (m->buf == NULL) {
+            m->size = 0;
+            m->out = 0;
+            m->in = 0;
+        } else {
+            ret = true;
+        }
+    }
+    pthread_mutex_unlock(&m->mutex);
+
+    return ret;
+}
+
+/*	song stopped writing frames, the other one of a crossfade takes over
+ */
+void BarSinksEndSong(BarSinks_t *const sinks, const uint32_t song) {
+    BarSinkMixer_t *const m = &sinks->mixer;
+    AVFrame *pending = NULL;
+
+    __atomic_store_n(&sinks->ended, song, __ATOMIC_RELEASE);
+
+    pthread_mutex_lock(&m->mutex);
+    const uint32_t in = m->in;
+    if (m->out != 0 && song == m->out) {
+        m->outDone = true;
+    } else if (m->in != 0 && song == m->in) {
+        m->inDone = true;
+        if (!m->outDone && m->outPos <= m->start) {
+            /* not faded yet, just keep playing out */
+            mixerReset(m, m->out, m->outPos);
+        }
+    }
+    if (m->out != 0 && m->outDone && m->inDone) {
+        pending = mixerTake(m);
+        mixerReset(m, m->in, m->inTotal);
+    }
+    pthread_cond_broadcast(&m->cond);
+    pthread_mutex_unlock(&m->mutex);
+
+    if (pending != NULL) {
+        volatile bool abort = false;
+        BarSinksQueue(sinks, pending, in, &abort);
+        av_frame_free(&pending);
+    }
+}
+
+/*	discard queued frames of song, i.e. when skipping it
+ */
+void BarSinksFlush(BarSinks_t *const sinks, const uint32_t song) {
+    /* an empty queue is expected now */
+    __atomic_store_n(&sinks->ended, song, __ATOMIC_RELEASE);
+
+    for (size_t i = 0; i < sinks->count; i++) {
+        BarSink_t *const sink = &sinks->sink[i];
+
+        pthread_mutex_lock(&sink->mutex);
+        size_t kept = 0;
+        for (size_t j = 0; j < sink->count; j++) {
+            BarSinkItem_t *const item =
+                &sink->queue[(sink->head + j) % sink->size];
+            if (item->song == song) {
+                av_frame_free(&item->frame);
+            } else {
+                sink->queue[(sink->head + kept) % sink->size] = *item;
+                ++kept;
+            }
+        }
+        sink->count = kept;
+        pthread_cond_broadcast(&sink->notFull);
+        pthread_mutex_unlock(&sink->mutex);
+    }
+
+    BarSinkMixer_t *const m = &sinks->mixer;
+    pthread_mutex_lock(&m->mutex);
+    if (m->in != 0 && song == m->in) {
+        m->head = 0;
+        m->count = 0;
+    }
+    pthread_mutex_unlock(&m->mutex);
+}
+
+/*	forget about previous errors, the device is opened again with the next
+ *	frame
+ */
+void BarSinksReset(BarSinks_t *const sinks) {
+    for (size_t i = 0; i < sinks->count; i++) {
+        sinks->sink[i].failed = false;
+    }
+}
+
+/*	stop/resume consuming queued frames
+ */
+void BarSinksPause(BarSinks_t *const sinks, const bool pause) {
+    for (size_t i = 0; i < sinks->count; i++) {
+        BarSink_t *const sink = &sinks->sink[i];
+
+        pthread_mutex_lock(&sink->mutex);
+        sink->paused = pause;
+        pthread_cond_broadcast(&sink->notEmpty);
+        pthread_mutex_unlock(&sink->mutex);
+    }
+}
+
+/*	get an id for a new song, its playback position starts at zero
+ */
+uint32_t BarSinksNewSong(BarSinks_t *const sinks) {
+    /* 0 is never used, so a zeroed player has no position */
+    if (++sinks->song == 0) {
+        ++sinks->song;
+    }
+    return sinks->song;
+}
+
+/*	Playback position of song, based on samples consumed by the device sink
+ *	rather than read from the network. Always 0 without a device sink, see
+ *	BarSinks_t.device. Lock-free, can be called from any thread.
+ *	@return milliseconds
+ */
+unsigned int BarSinksPosition(const BarSinks_t *const sinks,
+                              const uint32_t song) {
+    if (sinks == NULL) {
+        return 0;
+    }
+    const uint64_t position =
+        __atomic_load_n(&sinks->position, __ATOMIC_ACQUIRE);
+    return position >> 32 == song ? (uint32_t)position : 0;
+}
+
+/*	number of underruns since startup, lock-free
+ */
+unsigned int BarSinksUnderruns(const BarSinks_t *const sinks) {
+    return sinks == NULL ? 0
+                         : __atomic_load_n(&sinks->underruns, __ATOMIC_RELAXED);
+}
+
+/*	position of the latest underrun in song, lock-free
+ *	@return milliseconds, 0 if song had none
+ */
+unsigned int BarSinksLastUnderrun(const BarSinks_t *const sinks,
+                                  const uint32_t song) {
+    if (sinks == NULL) {
+        return 0;
+    }
+    const uint64_t last =
+        __atomic_load_n(&sinks->lastUnderrun, __ATOMIC_ACQUIRE);
+    return last >> 32 == song ? (uint32_t)last : 0;
+}
@@ -0,0 +1,147 @@
+/*
+Copyright (c) 2026
+        pianobar contributors
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#pragma once
+
+#include "config.h"
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include <ao/ao.h>
+#include <libavutil/frame.h>
+
+#include "settings.h"
+#include "tap.h"
+
+struct BarSink;
+
+typedef struct {
+    AVFrame *frame;
+    /* song the frame belongs to, see BarSinksNewSong */
+    uint32_t song;
+} BarSinkItem_t;
+
+typedef struct {
+    const char *name;
+    /* the device sink paces playback, all others drop frames if full */
+    bool blocking;
+    /* requires type:arg */
+    bool needsArg;
+    bool (*open)(struct BarSink *, int, int);
+    bool (*write)(struct BarSink *, const char *, size_t);
+    void (*close)(struct BarSink *);
+} BarSinkOps_t;
+
+typedef struct BarSink {
+    const BarSinkOps_t *ops;
+    /* part after the colon, may be NULL */
+    char *arg;
+    const BarSettings_t *settings;
+    BarTap_t *tap;
+
+    /* bounded queue of reference-counted frames, protected by mutex */
+    pthread_mutex_t mutex;
+    pthread_cond_t notEmpty, notFull;
+    BarSinkItem_t *queue;
+    size_t size, head, count;
+    bool quit, paused;
+    pthread_t thread;
+
+    /* output state, owned by the sink thread */
+    bool isOpen;
+    /* open failed, frames are discarded */
+    volatile bool failed;
+    int rate, channels;
+    ao_device *aoDev;
+    FILE *fp;
+    int fd;
+    /* format written to the file sink, 0 until it is opened */
+    int fileRate, fileChannels;
+
+    /* frames discarded because the queue was full */
+    volatile unsigned long dropped;
+
+    /* playback clock and underrun detection, only maintained by the device
+     * sink */
+    struct BarSinks *sinks;
+    uint32_t song;
+    uint64_t samples;
+} BarSink_t;
+
+/* crossfade between two songs, protected by mutex */
+typedef struct {
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    /* last song played without mixing and its format */
+    uint32_t song;
+    uint64_t samples;
+    int rate;
+    uint64_t channelLayout;
+    /* songs faded out and in, 0 if inactive */
+    uint32_t out, in;
+    /* song that has been faded out completely, its frames are dropped */
+    uint32_t faded;
+    bool outDone, inDone;
+    BarCrossfadeCurve_t curve;
+    /* fade region of out, positions of both songs, in samples per channel */
+    uint64_t start, length, outPos, inPos, inTotal;
+    /* audio of in waiting to be mixed, interleaved s16 */
+    int16_t *buf;
+    size_t size, head, count;
+} BarSinkMixer_t;
+
+typedef struct BarSinks {
+    BarSink_t *sink;
+    size_t count;
+    BarSinkMixer_t mixer;
+    /* last song id handed out */
+    uint32_t song;
+    /* a blocking sink paces playback and publishes the position */
+    bool device;
+    /* song id (upper 32 bits) and milliseconds played by the device sink
+     * (lower 32 bits), accessed atomically */
+    uint64_t position;
+    /* last song that stopped writing frames, accessed atomically */
+    uint32_t ended;
+    /* device sink ran out of audio while a song was playing; total and song
+     * id/position of the latest one, like position */
+    unsigned int underruns;
+    uint64_t lastUnderrun;
+} BarSinks_t;
+
+bool BarSinksInit(BarSinks_t *, const BarSettings_t *, BarTap_t *);
+void BarSinksDestroy(BarSinks_t *);
+bool BarSinksWrite(BarSinks_t *, const AVFrame *, uint32_t, volatile bool *);
+void BarSinksFlush(BarSinks_t *, uint32_t);
+void BarSinksReset(BarSinks_t *);
+void BarSinksPause(BarSinks_t *, bool);
+uint32_t BarSinksNewSong(BarSinks_t *);
+unsigned int BarSinksPosition(const BarSinks_t *, uint32_t);
+bool BarSinksCrossfade(BarSinks_t *, uint32_t, uint32_t, unsigned int,
+                       unsigned int, BarCrossfadeCurve_t);
+void BarSinksEndSong(BarSinks_t *, uint32_t);
+unsigned int BarSinksUnderruns(const BarSinks_t *);
+unsigned int BarSinksLastUnderrun(const BarSinks_t *, uint32_t);
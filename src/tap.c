@@ -0,0 +1,202 @@
+/*
+Copyright (c) 2026
+        pianobar contributors
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+/* publish output pcm and signal levels in a posix shared memory segment */
+
+#include "config.h"
+
+#include <assert.h>
+#include <fcntl.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "tap.h"
+
+/* ring buffer is sized for the highest sample rate we expect */
+#define BAR_TAP_MAXRATE 48000
+
+/*	create shared memory segment
+ *	@param segment name, i.e. /pianobar
+ *	@param amount of audio kept, in milliseconds
+ *	@return tap or NULL on error
+ */
+BarTap_t *BarTapOpen(const char *const name, unsigned int ms) {
+    assert(name != NULL);
+
+    /* multiple of every possible channel count, so frames never wrap */
+    const size_t size = (size_t)BAR_TAP_MAXRATE * ms / 1000 * 2 / 840 * 840;
+    const size_t mapSize = sizeof(BarTapShm_t) + size * sizeof(int16_t);
+    if (size == 0) {
+        return NULL;
+    }
+
+    /* playback position and audio are private, like the session file */
+    const int fd = shm_open(name, O_CREAT | O_RDWR, 0600);
+    if (fd == -1) {
+        return NULL;
+    }
+    if (ftruncate(fd, mapSize) == -1) {
+        close(fd);
+        shm_unlink(name);
+        return NULL;
+    }
+    BarTapShm_t *const shm =
+        mmap(NULL, mapSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    /* mapping stays valid */
+    close(fd);
+    if (shm == MAP_FAILED) {
+        shm_unlink(name);
+        return NULL;
+    }
+
+    memset(shm, 0, mapSize);
+    shm->version = BAR_TAP_VERSION;
+    shm->size = size;
+    /* readers check magic last */
+    __atomic_store_n(&shm->magic, BAR_TAP_MAGIC, __ATOMIC_RELEASE);
+
+    BarTap_t *const tap = calloc(1, sizeof(*tap));
+    if (tap == NULL || (tap->name = strdup(name)) == NULL) {
+        free(tap);
+        munmap(shm, mapSize);
+        shm_unlink(name);
+        return NULL;
+    }
+    tap->shm = shm;
+    tap->mapSize = mapSize;
+
+    return tap;
+}
+
+/*	destroy shared memory segment
+ */
+void BarTapClose(BarTap_t *const tap) {
+    if (tap == NULL) {
+        return;
+    }
+
+    munmap(tap->shm, tap->mapSize);
+    shm_unlink(tap->name);
+    free(tap->name);
+    free(tap);
+}
+
+/*	Compute sum of squares and peak for every channel. Kept branch-free with
+ *	a separate stereo path, so the compiler can vectorize the loops.
+ */
+static void BarTapLevels(const int16_t *restrict pcm, const size_t frames,
+                         const unsigned int channels, int64_t *restrict sum,
+                         int32_t *restrict peak) {
+    if (channels == 2) {
+        int64_t suml = 0, sumr = 0;
+        int32_t peakl = 0, peakr = 0;
+        for (size_t i = 0; i < frames; i++) {
+            const int32_t l = pcm[2 * i], r = pcm[2 * i + 1];
+            const int32_t al = l < 0 ? -l : l, ar = r < 0 ? -r : r;
+            suml += l * l;
+            sumr += r * r;
+            peakl = al > peakl ? al : peakl;
+            peakr = ar > peakr ? ar : peakr;
+        }
+        sum[0] = suml;
+        sum[1] = sumr;
+        peak[0] = peakl;
+        peak[1] = peakr;
+    } else {
+        for (unsigned int c = 0; c < channels; c++) {
+            int64_t s = 0;
+            int32_t p = 0;
+            for (size_t i = 0; i < frames; i++) {
+                const int32_t v = pcm[i * channels + c];
+                const int32_t av = v < 0 ? -v : v;
+                s += v * v;
+                p = av > p ? av : p;
+            }
+            sum[c] = s;
+            peak[c] = p;
+        }
+    }
+}
+
+/*	Publish samples passed to the audio device. Never blocks and does not
+ *	enter the kernel.
+ *	@param tap
+ *	@param interleaved samples
+ *	@param number of frames
+ *	@param channels
+ *	@param sample rate
+ */
+void BarTapWrite(BarTap_t *const tap, const int16_t *const pcm,
+                 const size_t frames, const unsigned int channels,
+                 const unsigned int rate) {
+    if (tap == NULL || frames == 0 || channels == 0 ||
+        channels > BAR_TAP_MAXCHANNELS) {
+        return;
+    }
+
+    BarTapShm_t *const shm = tap->shm;
+
+    int64_t sum[BAR_TAP_MAXCHANNELS];
+    int32_t peak[BAR_TAP_MAXCHANNELS];
+    BarTapLevels(pcm, frames, channels, sum, peak);
+
+    /* only the most recent samples fit into the ring */
+    size_t samples = frames * channels;
+    const int16_t *src = pcm;
+    if (samples > shm->size) {
+        src += samples - shm->size;
+        samples = shm->size;
+    }
+    assert(samples % channels == 0);
+
+    const uint32_t seq = shm->seq;
+    __atomic_store_n(&shm->seq, seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    if (channels != shm->channels) {
+        /* keep frames aligned to the ring start */
+        shm->written = (shm->written + channels - 1) / channels * channels;
+    }
+    const size_t pos = shm->written % shm->size;
+    const size_t first = samples < shm->size - pos ? samples : shm->size - pos;
+    memcpy(&shm->pcm[pos], src, first * sizeof(*src));
+    memcpy(&shm->pcm[0], src + first, (samples - first) * sizeof(*src));
+    shm->written += samples;
+    shm->rate = rate;
+    shm->channels = channels;
+    for (unsigned int c = 0; c < BAR_TAP_MAXCHANNELS; c++) {
+        if (c < channels) {
+            shm->rms[c] = sqrt((double)sum[c] / frames) / 32768.0;
+            shm->peak[c] = peak[c] / 32768.0f;
+        } else {
+            shm->rms[c] = 0;
+            shm->peak[c] = 0;
+        }
+    }
+
+    __atomic_store_n(&shm->seq, seq + 2, __ATOMIC_RELEASE);
+}
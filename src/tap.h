@@ -0,0 +1,70 @@
+/*
+Copyright (c) 2026
+        pianobar contributors
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Layout of the shared memory segment. This header can be used by external
+ * readers as well. Readers must use the seqlock protocol:
+ *
+ *	do {
+ *		s1 = seq (acquire); if (s1 & 1) retry;
+ *		copy what you need;
+ *		s2 = seq (acquire, after a read fence);
+ *	} while (s1 != s2);
+ */
+#define BAR_TAP_MAGIC 0x70626172
+#define BAR_TAP_VERSION 1
+#define BAR_TAP_MAXCHANNELS 8
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    /* odd while the player is updating the segment */
+    volatile uint32_t seq;
+    /* format of the most recent samples */
+    uint32_t rate;
+    uint32_t channels;
+    /* ring buffer size in samples (not frames) */
+    uint32_t size;
+    /* samples written in total, ring write position is written % size */
+    uint64_t written;
+    /* levels of the most recent buffer, full scale is 1.0 */
+    float rms[BAR_TAP_MAXCHANNELS];
+    float peak[BAR_TAP_MAXCHANNELS];
+    /* interleaved signed 16 bit native endian samples */
+    int16_t pcm[];
+} BarTapShm_t;
+
+typedef struct {
+    char *name;
+    BarTapShm_t *shm;
+    size_t mapSize;
+} BarTap_t;
+
+BarTap_t *BarTapOpen(const char *, unsigned int);
+void BarTapClose(BarTap_t *);
+void BarTapWrite(BarTap_t *, const int16_t *, size_t, unsigned int,
+                 unsigned int);
@@ -28,6 +28,7 @@ THE SOFTWARE.
 #include <assert.h>
 #include <ctype.h> /* tolower() */
 #include <errno.h>
+#include <pthread.h>
 #include <stdarg.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -87,6 +88,23 @@ static const char *BarStrCaseStr(const char *haystack, const char *needle) {
   return NULL;
 }
 
+/* per thread destination of BarUiMsg, stdout if unset */
+static pthread_key_t msgCaptureKey;
+static pthread_once_t msgCaptureOnce = PTHREAD_ONCE_INIT;
+
+static void BarUiMsgCaptureInit(void) {
+  pthread_key_create(&msgCaptureKey, NULL);
+}
+
+/*	Write messages of the calling thread to fp instead of stdout, so they
+ *	can be printed later by the main thread without interleaving.
+ *	@param stream, NULL to print to stdout again
+ */
+void BarUiMsgCapture(FILE *fp) {
+  pthread_once(&msgCaptureOnce, BarUiMsgCaptureInit);
+  pthread_setspecific(msgCaptureKey, fp);
+}
+
 /*	output message and flush stdout
  *	@param message
  */
@@ -98,6 +116,12 @@ void BarUiMsg(const BarSettings_t *settings, const BarUiMsg_t type,
   assert(type < MSG_COUNT);
   assert(format != NULL);
 
+  pthread_once(&msgCaptureOnce, BarUiMsgCaptureInit);
+  FILE *out = pthread_getspecific(msgCaptureKey);
+  if (out == NULL) {
+    out = stdout;
+  }
+
   switch (type) {
     case MSG_INFO:
     case MSG_PLAYING:
@@ -106,7 +130,7 @@ void BarUiMsg(const BarSettings_t *settings, const BarUiMsg_t type,
     case MSG_QUESTION:
     case MSG_LIST:
       /* print ANSI clear line */
-      fputs("\033[2K", stdout);
+      fputs("\033[2K", out);
       break;
 
     default:
@@ -114,214 +138,83 @@ void BarUiMsg(const BarSettings_t *settings, const BarUiMsg_t type,
   }
 
   if (settings->msgFormat[type].prefix != NULL) {
-    fputs(settings->msgFormat[type].prefix, stdout);
+    fputs(settings->msgFormat[type].prefix, out);
   }
 
   va_start(fmtargs, format);
-  vprintf(format, fmtargs);
+  vfprintf(out, format, fmtargs);
   va_end(fmtargs);
 
   if (settings->msgFormat[type].postfix != NULL) {
-    fputs(settings->msgFormat[type].postfix, stdout);
-  }
-
-  fflush(stdout);
-}
-
-typedef struct {
-  char *data;
-  size_t pos;
-} buffer;
-
-static size_t httpFetchCb(char *ptr, size_t size, size_t nmemb,
-                          void *userdata) {
-  buffer *const buffer = userdata;
-  size_t recvSize = size * nmemb;
-
-  if (buffer->data == NULL) {
-    if ((buffer->data = malloc(sizeof(*buffer->data) * (recvSize + 1))) ==
-        NULL) {
-      return 0;
-    }
-  } else {
-    char *newbuf;
-    if ((newbuf = realloc(buffer->data, sizeof(*buffer->data) *
-                                            (buffer->pos + recvSize + 1))) ==
-        NULL) {
-      free(buffer->data);
-      return 0;
-    }
-    buffer->data = newbuf;
+    fputs(settings->msgFormat[type].postfix, out);
   }
-  memcpy(buffer->data + buffer->pos, ptr, recvSize);
-  buffer->pos += recvSize;
-  buffer->data[buffer->pos] = '\0';
 
-  return recvSize;
+  fflush(out);
 }
 
-/*	libcurl progress callback. aborts the current request if user pressed ^C
+/*	print the result of a pandora api call
+ *	@return true if the call succeeded
  */
-int progressCb(void *const data, double dltotal, double dlnow, double ultotal,
-               double ulnow) {
-  const sig_atomic_t lint = *((sig_atomic_t *)data);
-  if (lint) {
-    return 1;
-  } else {
-    return 0;
+bool BarUiPianoResult(const BarSettings_t *const settings,
+                      const PianoReturn_t pRet, const CURLcode wRet) {
+  if (wRet == CURLE_ABORTED_BY_CALLBACK) {
+    BarUiMsg(settings, MSG_NONE, "Interrupted.\n");
+    return false;
+  } else if (wRet != CURLE_OK) {
+    BarUiMsg(settings, MSG_NONE, "Network error: %s\n",
+             curl_easy_strerror(wRet));
+    return false;
+  } else if (pRet != PIANO_RET_OK) {
+    BarUiMsg(settings, MSG_NONE, "Error: %s\n", PianoErrorToStr(pRet));
+    return false;
   }
+  BarUiMsg(settings, MSG_NONE, "Ok.\n");
+  return true;
 }
 
-#define setAndCheck(k, v)                 \
-  httpret = curl_easy_setopt(http, k, v); \
-  assert(httpret == CURLE_OK);
+typedef struct {
+  bool done;
+  PianoReturn_t pRet;
+  CURLcode wRet;
+} BarUiPianoCallResult_t;
+
+static void BarUiPianoCallDone(BarRpcCall_t *const call, void *const data) {
+  BarUiPianoCallResult_t *const result = data;
+  result->done = true;
+  result->pRet = call->pRet;
+  result->wRet = call->wRet;
+}
 
-static CURLcode BarPianoHttpRequest(CURL *const http,
-                                    const BarSettings_t *const settings,
-                                    PianoRequest_t *const req) {
-  buffer buffer = {NULL, 0};
+/*	piano wrapper: run api call and wait for its completion. Calls in the
+ *	background make progress meanwhile, but their callbacks are run by the
+ *	main loop, since they may free stations or songs the caller is using.
+ */
+bool BarUiPianoCall(BarApp_t *const app, const PianoRequestType_t type,
+                    void *const data, PianoReturn_t *const pRet,
+                    CURLcode *const wRet) {
+  BarUiPianoCallResult_t result = {.done = false,
+                                   .pRet = PIANO_RET_OK,
+                                   .wRet = CURLE_OUT_OF_MEMORY};
   sig_atomic_t lint = 0, *prevint;
 
-  char url[2048];
-  assert(settings->rpcHost != NULL);
-  assert(settings->rpcTlsPort != NULL);
-  assert(req->urlPath != NULL);
-  int ret = snprintf(url, sizeof(url), "%s://%s:%s%s",
-                     req->secure ? "https" : "http", settings->rpcHost,
-                     req->secure ? settings->rpcTlsPort : "80", req->urlPath);
-  assert(ret >= 0 && ret <= (int)sizeof(url));
-
   /* save the previous interrupt destination */
   prevint = interrupted;
   interrupted = &lint;
 
-  curl_easy_reset(http);
-  CURLcode httpret;
-  setAndCheck(CURLOPT_URL, url);
-  setAndCheck(CURLOPT_USERAGENT, PACKAGE "-" VERSION);
-  setAndCheck(CURLOPT_POSTFIELDS, req->postData);
-  setAndCheck(CURLOPT_WRITEFUNCTION, httpFetchCb);
-  setAndCheck(CURLOPT_WRITEDATA, &buffer);
-  setAndCheck(CURLOPT_PROGRESSFUNCTION, progressCb);
-  setAndCheck(CURLOPT_PROGRESSDATA, &lint);
-  setAndCheck(CURLOPT_NOPROGRESS, 0);
-  setAndCheck(CURLOPT_POST, 1);
-  if (settings->caBundle != NULL) {
-    setAndCheck(CURLOPT_CAINFO, settings->caBundle);
-  }
-
-  if (settings->bindTo != NULL) {
-    if (curl_easy_setopt(http, CURLOPT_INTERFACE, settings->bindTo) !=
-        CURLE_OK) {
-      /* if binding fails, notice about that */
-      BarUiMsg(settings, MSG_ERR, "bindTo (%s) is invalid!\n",
-               settings->bindTo);
+  const BarRpcCall_t *const call = BarRpcSubmit(
+      &app->rpc, type, data, &lint, BarUiPianoCallDone, &result);
+  if (call != NULL) {
+    while (!result.done) {
+      BarRpcWait(&app->rpc, NULL, 1000, call);
     }
   }
 
-  /* set up proxy (control proxy for non-us citizen or global proxy for poor
-   * firewalled fellows) */
-  if (settings->controlProxy != NULL) {
-    /* control proxy overrides global proxy */
-    if (curl_easy_setopt(http, CURLOPT_PROXY, settings->controlProxy) !=
-        CURLE_OK) {
-      /* if setting proxy fails, url is invalid */
-      BarUiMsg(settings, MSG_ERR, "Control proxy (%s) is invalid!\n",
-               settings->controlProxy);
-    }
-  } else if (settings->proxy != NULL && strlen(settings->proxy) > 0) {
-    if (curl_easy_setopt(http, CURLOPT_PROXY, settings->proxy) != CURLE_OK) {
-      /* if setting proxy fails, url is invalid */
-      BarUiMsg(settings, MSG_ERR, "Proxy (%s) is invalid!\n", settings->proxy);
-    }
-  }
-
-  struct curl_slist *list = NULL;
-  list = curl_slist_append(list, "Content-Type: text/plain");
-  setAndCheck(CURLOPT_HTTPHEADER, list);
-
-  httpret = curl_easy_perform(http);
-
-  curl_slist_free_all(list);
-
-  req->responseData = buffer.data;
-
   interrupted = prevint;
 
-  return httpret;
-}
-
-/*	piano wrapper: prepare/execute http request and pass result back to
- *	libpiano
- */
-bool BarUiPianoCall(BarApp_t *const app, const PianoRequestType_t type,
-                    void *const data, PianoReturn_t *const pRet,
-                    CURLcode *const wRet) {
-  PianoReturn_t pRetLocal = PIANO_RET_OK;
-  CURLcode wRetLocal = CURLE_OK;
-  bool ret = false;
-
-  /* repeat as long as there are http requests to do */
-  do {
-    PianoRequest_t req = {.data = data, .responseData = NULL};
-
-    pRetLocal = PianoRequest(&app->ph, &req, type);
-    if (pRetLocal != PIANO_RET_OK) {
-      BarUiMsg(&app->settings, MSG_NONE, "Error: %s\n",
-               PianoErrorToStr(pRetLocal));
-      goto cleanup;
-    }
+  *pRet = result.pRet;
+  *wRet = result.wRet;
 
-    wRetLocal = BarPianoHttpRequest(app->http, &app->settings, &req);
-    if (wRetLocal == CURLE_ABORTED_BY_CALLBACK) {
-      BarUiMsg(&app->settings, MSG_NONE, "Interrupted.\n");
-      goto cleanup;
-    } else if (wRetLocal != CURLE_OK) {
-      BarUiMsg(&app->settings, MSG_NONE, "Network error: %s\n",
-               curl_easy_strerror(wRetLocal));
-      goto cleanup;
-    }
-
-    pRetLocal = PianoResponse(&app->ph, &req);
-    if (pRetLocal != PIANO_RET_CONTINUE_REQUEST) {
-      /* checking for request type avoids infinite loops */
-      if (pRetLocal == PIANO_RET_P_INVALID_AUTH_TOKEN &&
-          type != PIANO_REQUEST_LOGIN) {
-        /* reauthenticate */
-        PianoRequestDataLogin_t reqData;
-        reqData.user = app->settings.username;
-        reqData.password = app->settings.password;
-        reqData.step = 0;
-
-        BarUiMsg(&app->settings, MSG_NONE, "Reauthentication required... ");
-        if (!BarUiPianoCall(app, PIANO_REQUEST_LOGIN, &reqData, &pRetLocal,
-                            &wRetLocal)) {
-          goto cleanup;
-        } else {
-          /* try again */
-          pRetLocal = PIANO_RET_CONTINUE_REQUEST;
-          BarUiMsg(&app->settings, MSG_INFO, "Trying again... ");
-        }
-      } else if (pRetLocal != PIANO_RET_OK) {
-        BarUiMsg(&app->settings, MSG_NONE, "Error: %s\n",
-                 PianoErrorToStr(pRetLocal));
-        goto cleanup;
-      } else {
-        BarUiMsg(&app->settings, MSG_NONE, "Ok.\n");
-        ret = true;
-      }
-    }
-
-  cleanup:
-    /* persistent data is stored in req.data */
-    free(req.responseData);
-    PianoDestroyRequest(&req);
-  } while (pRetLocal == PIANO_RET_CONTINUE_REQUEST);
-
-  *pRet = pRetLocal;
-  *wRet = wRetLocal;
-
-  return ret;
+  return BarUiPianoResult(&app->settings, result.pRet, result.wRet);
 }
 
 /*	Station sorting functions */
@@ -573,9 +466,15 @@ char *BarUiSelectMusicId(BarApp_t *app, PianoStation_t *station,
 
     reqData.searchStr = lineBuf;
 
-    BarUiMsg(&app->settings, MSG_INFO, "Searching... ");
-    if (!BarUiPianoCall(app, PIANO_REQUEST_SEARCH, &reqData, &pRet, &wRet)) {
-      return NULL;
+    /* the same few searches are repeated over and over */
+    if (!BarSearchCacheGet(&app->searchCache, lineBuf,
+                           &reqData.searchResult)) {
+      BarUiMsg(&app->settings, MSG_INFO, "Searching... ");
+      if (!BarUiPianoCall(app, PIANO_REQUEST_SEARCH, &reqData, &pRet,
+                          &wRet)) {
+        return NULL;
+      }
+      BarSearchCachePut(&app->searchCache, lineBuf, &reqData.searchResult);
     }
     memcpy(&searchResult, &reqData.searchResult, sizeof(searchResult));
 
@@ -770,15 +669,19 @@ size_t BarUiListSongs(const BarSettings_t *settings, const PianoSong_t *song,
  *	@param event type
  *	@param current station
  *	@param current song
+ *	@param player
+ *	@param piano handle, its stations are listed, may be NULL
  *	@param piano error-code (PIANO_RET_OK if not applicable)
  */
 void BarUiStartEventCmd(const BarSettings_t *settings, const char *type,
                         const PianoStation_t *curStation,
                         const PianoSong_t *curSong,
-                        const player_t *const player, PianoStation_t *stations,
-                        PianoReturn_t pRet, CURLcode wRet) {
+                        const player_t *const player,
+                        const PianoHandle_t *const ph, PianoReturn_t pRet,
+                        CURLcode wRet) {
   pid_t chld;
   int pipeFd[2];
+  PianoStation_t *const stations = ph == NULL ? NULL : ph->stations;
 
   if (settings->eventCmd == NULL) {
     /* nothing to do... */
@@ -816,7 +719,7 @@ void BarUiStartEventCmd(const BarSettings_t *settings, const char *type,
 
     if (curSong != NULL && stations != NULL && curStation != NULL &&
         curStation->isQuickMix) {
-      songStation = PianoFindStationById(stations, curSong->stationId);
+      songStation = PianoFindStationById(ph, curSong->stationId);
     }
 
     fprintf(pipeWriteFd,
@@ -832,8 +735,20 @@ void BarUiStartEventCmd(const BarSettings_t *settings, const char *type,
             "wRetStr=%s\n"
             "songDuration=%u\n"
             "songPlayed=%u\n"
+            "songPlayedMs=%u\n"
             "rating=%i\n"
-            "detailUrl=%s\n",
+            "detailUrl=%s\n"
+            "filterSetupUs=%u\n"
+            "filterReused=%i\n"
+            "silenceTrimmedMs=%u\n"
+            "underruns=%u\n"
+            "underrunAtMs=%u\n"
+            "stalls=%u\n"
+            "stallMs=%u\n"
+            "stallAtMs=%u\n"
+            "decodeErrors=%u\n"
+            "decodeErrorAtMs=%u\n"
+            "retries=%u\n",
             curSong == NULL ? "" : curSong->artist,
             curSong == NULL ? "" : curSong->title,
             curSong == NULL ? "" : curSong->album,
@@ -842,8 +757,15 @@ void BarUiStartEventCmd(const BarSettings_t *settings, const char *type,
             songStation == NULL ? "" : songStation->name, pRet,
             PianoErrorToStr(pRet), wRet, curl_easy_strerror(wRet),
             player->songDuration, player->songPlayed,
+            BarPlayerPosition(player),
             curSong == NULL ? PIANO_RATE_NONE : curSong->rating,
-            curSong == NULL ? "" : curSong->detailUrl);
+            curSong == NULL ? "" : curSong->detailUrl,
+            player->stats.filterSetupUs, player->stats.filterReused,
+            player->stats.trimmedMs, player->counters.underruns,
+            player->counters.underrunAt, player->counters.stalls,
+            player->counters.stallMs, player->counters.stallAt,
+            player->counters.decodeErrors, player->counters.decodeErrorAt,
+            player->counters.retries);
 
     if (stations != NULL) {
       /* send station list */
@@ -882,16 +804,13 @@ void BarUiHistoryPrepend(BarApp_t *app, PianoSong_t *song) {
 
   if (app->settings.history != 0) {
     app->songHistory = PianoListPrependP(app->songHistory, song);
-    PianoSong_t *del;
-    do {
-      del = PianoListGetP(app->songHistory, app->settings.history);
-      if (del != NULL) {
-        app->songHistory = PianoListDeleteP(app->songHistory, del);
-        PianoDestroyPlaylist(del);
-      } else {
-        break;
-      }
-    } while (true);
+    /* cut off everything after the last song kept, in a single pass */
+    PianoSong_t *const last =
+        PianoListGetP(app->songHistory, app->settings.history - 1);
+    if (last != NULL && last->head.next != NULL) {
+      PianoDestroyPlaylist(PianoListNextP(last));
+      last->head.next = NULL;
+    }
   } else {
     PianoDestroyPlaylist(song);
   }
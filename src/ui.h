@@ -24,6 +24,7 @@ THE SOFTWARE.
 #pragma once
 
 #include <stdbool.h>
+#include <stdio.h>
 
 #include <piano.h>
 
@@ -37,6 +38,7 @@ typedef void (*BarUiSelectStationCallback_t)(BarApp_t *app, char *buf);
 
 void BarUiMsg(const BarSettings_t *, const BarUiMsg_t, const char *, ...)
     __attribute__((format(printf, 3, 4)));
+void BarUiMsgCapture(FILE *);
 PianoStation_t *BarUiSelectStation(BarApp_t *, PianoStation_t *, const char *,
                                    BarUiSelectStationCallback_t, bool);
 PianoSong_t *BarUiSelectSong(const BarSettings_t *, PianoSong_t *,
@@ -49,8 +51,9 @@ void BarUiPrintSong(const BarSettings_t *, const PianoSong_t *,
 size_t BarUiListSongs(const BarSettings_t *, const PianoSong_t *, const char *);
 void BarUiStartEventCmd(const BarSettings_t *, const char *,
                         const PianoStation_t *, const PianoSong_t *,
-                        const player_t *, PianoStation_t *, PianoReturn_t,
-                        CURLcode);
+                        const player_t *, const PianoHandle_t *,
+                        PianoReturn_t, CURLcode);
 bool BarUiPianoCall(BarApp_t *const, const PianoRequestType_t, void *,
                     PianoReturn_t *, CURLcode *);
 void BarUiHistoryPrepend(BarApp_t *app, PianoSong_t *song);
+bool BarUiPianoResult(const BarSettings_t *, PianoReturn_t, CURLcode);
@@ -30,6 +30,7 @@ THE SOFTWARE.
 #include <string.h>
 #include <unistd.h>
 
+#include "genres.h"
 #include "ui.h"
 #include "ui_dispatch.h"
 #include "ui_readline.h"
@@ -37,14 +38,39 @@ THE SOFTWARE.
 /*	standard eventcmd call
  */
 #define BarUiActDefaultEventcmd(name)                                         \
-  BarUiStartEventCmd(&app->settings, name, selStation, selSong, &app->player, \
-                     app->ph.stations, pRet, wRet)
+  BarUiStartEventCmd(&app->settings, name, selStation, selSong, app->player, \
+                     &app->ph, pRet, wRet)
 
 /*	standard piano call
  */
 #define BarUiActDefaultPianoCall(call, arg) \
   BarUiPianoCall(app, call, arg, &pRet, &wRet)
 
+/*	standard background call
+ */
+#define BarUiActDefaultQueue(type) \
+  BarUiActQueue(app, type, selSong, &pRet, &wRet)
+
+/*	queue feedback in the journal and start sending it
+ *	@param app
+ *	@param feedback type
+ *	@param song
+ *	@param piano return value, OK if queued
+ *	@param curl return value
+ *	@return true if queued
+ */
+static bool BarUiActQueue(BarApp_t *const app, const BarJournalType_t type,
+                          const PianoSong_t *const song,
+                          PianoReturn_t *const pRet, CURLcode *const wRet) {
+  const bool ok = BarJournalAdd(&app->journal, type, song);
+  *pRet = ok ? PIANO_RET_OK : PIANO_RET_OUT_OF_MEMORY;
+  *wRet = CURLE_OK;
+  if (ok) {
+    BarJournalFlush(&app->journal);
+  }
+  return BarUiPianoResult(&app->settings, *pRet, *wRet);
+}
+
 /*	helper to _really_ skip a song (unlock mutex, quit player)
  *	@param player handle
  */
@@ -58,6 +84,28 @@ static inline void BarUiDoSkipSong(player_t *const player) {
   pthread_mutex_unlock(&player->pauseMutex);
 }
 
+/*	drop upcoming songs. A song that is being faded in is skipped, but
+ *	stays in the playlist until its player is done.
+ */
+static void BarUiDrainPlaylist(BarApp_t *const app) {
+  /* playlist of the previous station is not needed any more */
+  BarRpcCancel(&app->rpc, app->playlistCall);
+  app->playlistCall = NULL;
+
+  if (app->playlist == NULL) {
+    return;
+  }
+
+  PianoSong_t *keep = app->playlist;
+  if (app->nextPlayer != NULL) {
+    BarUiDoSkipSong(app->nextPlayer);
+    keep = PianoListNextP(keep);
+    assert(keep != NULL);
+  }
+  PianoDestroyPlaylist(PianoListNextP(keep));
+  keep->head.next = NULL;
+}
+
 /*	transform station if necessary to allow changes like rename, rate, ...
  *	@param piano handle
  *	@param transform this station
@@ -131,8 +179,8 @@ BarUiActCallback(BarUiActBanSong) {
   assert(selSong != NULL);
   assert(selSong->stationId != NULL);
 
-  if ((realStation = PianoFindStationById(app->ph.stations,
-                                          selSong->stationId)) == NULL) {
+  if ((realStation = PianoFindStationById(&app->ph, selSong->stationId)) ==
+      NULL) {
     assert(0);
     return;
   }
@@ -140,14 +188,12 @@ BarUiActCallback(BarUiActBanSong) {
     return;
   }
 
-  PianoRequestDataRateSong_t reqData;
-  reqData.song = selSong;
-  reqData.rating = PIANO_RATE_BAN;
-
   BarUiMsg(&app->settings, MSG_INFO, "Banning song... ");
-  if (BarUiActDefaultPianoCall(PIANO_REQUEST_RATE_SONG, &reqData) &&
-      selSong == app->playlist) {
-    BarUiDoSkipSong(&app->player);
+  if (BarUiActDefaultQueue(BAR_JOURNAL_BAN)) {
+    selSong->rating = PIANO_RATE_BAN;
+    if (selSong == app->playlist) {
+      BarUiDoSkipSong(app->player);
+    }
   }
   BarUiActDefaultEventcmd("songban");
 }
@@ -235,13 +281,9 @@ BarUiActCallback(BarUiActDeleteStation) {
     BarUiMsg(&app->settings, MSG_INFO, "Deleting station... ");
     if (BarUiActDefaultPianoCall(PIANO_REQUEST_DELETE_STATION, selStation) &&
         selStation == app->curStation) {
-      BarUiDoSkipSong(&app->player);
-      if (app->playlist != NULL) {
-        /* drain playlist */
-        PianoDestroyPlaylist(PianoListNextP(app->playlist));
-        app->playlist->head.next = NULL;
-        selSong = NULL;
-      }
+      BarUiDoSkipSong(app->player);
+      BarUiDrainPlaylist(app);
+      selSong = NULL;
       app->nextStation = NULL;
       /* XXX: usually we shoudn’t touch cur*, but DELETE_STATION destroys
        * station struct */
@@ -271,6 +313,25 @@ BarUiActCallback(BarUiActExplain) {
   BarUiActDefaultEventcmd("songexplain");
 }
 
+/*	genre catalog refreshed in the background
+ */
+static void BarUiActGenresDone(BarRpcCall_t *const call, void *const data) {
+  BarApp_t *const app = data;
+  PianoGenreCategory_t *const categories = app->genreReq.retCategories;
+
+  app->genreCall = NULL;
+  app->genreReq.retCategories = NULL;
+  if (call->pRet != PIANO_RET_OK || call->wRet != CURLE_OK ||
+      categories == NULL) {
+    PianoDestroyGenreStations(categories);
+    return;
+  }
+
+  BarGenresSave(categories, app->settings.genreCache);
+  PianoDestroyGenreStations(app->genreUpdate);
+  app->genreUpdate = categories;
+}
+
 /*	choose genre station and add it as shared station
  */
 BarUiActCallback(BarUiActStationFromGenre) {
@@ -280,8 +341,18 @@ BarUiActCallback(BarUiActStationFromGenre) {
   const PianoGenre_t *curGenre;
   int i;
 
-  /* receive genre stations list if not yet available */
-  if (app->ph.genreStations == NULL) {
+  /* refreshed in the background since they were shown last time */
+  if (app->genreUpdate != NULL) {
+    PianoDestroyGenreStations(app->ph.genreStations);
+    app->ph.genreStations = app->genreUpdate;
+    app->genreUpdate = NULL;
+  }
+
+  /* load genre stations list from cache or receive it if not yet available */
+  bool stale = false;
+  if (app->ph.genreStations == NULL &&
+      !BarGenresLoad(&app->ph.genreStations, app->settings.genreCache,
+                     app->settings.genreCacheTtl, &stale)) {
     BarUiMsg(&app->settings, MSG_INFO, "Receiving genre stations... ");
     const bool ret =
         BarUiActDefaultPianoCall(PIANO_REQUEST_GET_GENRE_STATIONS, NULL);
@@ -289,6 +360,14 @@ BarUiActCallback(BarUiActStationFromGenre) {
     if (!ret) {
       return;
     }
+    if (app->settings.genreCacheTtl > 0) {
+      BarGenresSave(app->ph.genreStations, app->settings.genreCache);
+    }
+  }
+  if (stale && app->genreCall == NULL) {
+    app->genreCall =
+        BarRpcSubmit(&app->rpc, PIANO_REQUEST_GET_GENRE_STATIONS,
+                     &app->genreReq, NULL, BarUiActGenresDone, app);
   }
 
   /* print all available categories */
@@ -345,7 +424,7 @@ BarUiActCallback(BarUiActSongInfo) {
   BarUiPrintSong(
       &app->settings, selSong,
       selStation->isQuickMix
-          ? PianoFindStationById(app->ph.stations, selSong->stationId)
+          ? PianoFindStationById(&app->ph, selSong->stationId)
           : NULL);
 }
 
@@ -385,8 +464,8 @@ BarUiActCallback(BarUiActLoveSong) {
   assert(selSong != NULL);
   assert(selSong->stationId != NULL);
 
-  if ((realStation = PianoFindStationById(app->ph.stations,
-                                          selSong->stationId)) == NULL) {
+  if ((realStation = PianoFindStationById(&app->ph, selSong->stationId)) ==
+      NULL) {
     assert(0);
     return;
   }
@@ -394,44 +473,42 @@ BarUiActCallback(BarUiActLoveSong) {
     return;
   }
 
-  PianoRequestDataRateSong_t reqData;
-  reqData.song = selSong;
-  reqData.rating = PIANO_RATE_LOVE;
-
   BarUiMsg(&app->settings, MSG_INFO, "Loving song... ");
-  BarUiActDefaultPianoCall(PIANO_REQUEST_RATE_SONG, &reqData);
+  if (BarUiActDefaultQueue(BAR_JOURNAL_LOVE)) {
+    selSong->rating = PIANO_RATE_LOVE;
+  }
   BarUiActDefaultEventcmd("songlove");
 }
 
 /*	skip song
  */
-BarUiActCallback(BarUiActSkipSong) { BarUiDoSkipSong(&app->player); }
+BarUiActCallback(BarUiActSkipSong) { BarUiDoSkipSong(app->player); }
 
 /*	play
  */
 BarUiActCallback(BarUiActPlay) {
-  pthread_mutex_lock(&app->player.pauseMutex);
-  app->player.doPause = false;
-  pthread_cond_broadcast(&app->player.pauseCond);
-  pthread_mutex_unlock(&app->player.pauseMutex);
+  pthread_mutex_lock(&app->player->pauseMutex);
+  app->player->doPause = false;
+  pthread_cond_broadcast(&app->player->pauseCond);
+  pthread_mutex_unlock(&app->player->pauseMutex);
 }
 
 /*	pause
  */
 BarUiActCallback(BarUiActPause) {
-  pthread_mutex_lock(&app->player.pauseMutex);
-  app->player.doPause = true;
-  pthread_cond_broadcast(&app->player.pauseCond);
-  pthread_mutex_unlock(&app->player.pauseMutex);
+  pthread_mutex_lock(&app->player->pauseMutex);
+  app->player->doPause = true;
+  pthread_cond_broadcast(&app->player->pauseCond);
+  pthread_mutex_unlock(&app->player->pauseMutex);
 }
 
 /*	toggle pause
  */
 BarUiActCallback(BarUiActTogglePause) {
-  pthread_mutex_lock(&app->player.pauseMutex);
-  app->player.doPause = !app->player.doPause;
-  pthread_cond_broadcast(&app->player.pauseCond);
-  pthread_mutex_unlock(&app->player.pauseMutex);
+  pthread_mutex_lock(&app->player->pauseMutex);
+  app->player->doPause = !app->player->doPause;
+  pthread_cond_broadcast(&app->player->pauseCond);
+  pthread_mutex_unlock(&app->player->pauseMutex);
 }
 
 /*	rename current station
@@ -468,12 +545,8 @@ BarUiActCallback(BarUiActSelectStation) {
                          app->settings.autoselect);
   if (newStation != NULL) {
     app->nextStation = newStation;
-    BarUiDoSkipSong(&app->player);
-    if (app->playlist != NULL) {
-      /* drain playlist */
-      PianoDestroyPlaylist(PianoListNextP(app->playlist));
-      app->playlist->head.next = NULL;
-    }
+    BarUiDoSkipSong(app->player);
+    BarUiDrainPlaylist(app);
   }
 }
 
@@ -486,9 +559,8 @@ BarUiActCallback(BarUiActTempBanSong) {
   assert(selSong != NULL);
 
   BarUiMsg(&app->settings, MSG_INFO, "Putting song on shelf... ");
-  if (BarUiActDefaultPianoCall(PIANO_REQUEST_ADD_TIRED_SONG, selSong) &&
-      selSong == app->playlist) {
-    BarUiDoSkipSong(&app->player);
+  if (BarUiActDefaultQueue(BAR_JOURNAL_TIRED) && selSong == app->playlist) {
+    BarUiDoSkipSong(app->player);
   }
   BarUiActDefaultEventcmd("songshelf");
 }
@@ -566,7 +638,7 @@ BarUiActCallback(BarUiActSelectQuickMix) {
  */
 BarUiActCallback(BarUiActQuit) {
   app->doQuit = true;
-  BarUiDoSkipSong(&app->player);
+  BarUiDoSkipSong(app->player);
 }
 
 /*	song history
@@ -580,7 +652,7 @@ BarUiActCallback(BarUiActHistory) {
     if (histSong != NULL) {
       BarKeyShortcutId_t action;
       PianoStation_t *songStation =
-          PianoFindStationById(app->ph.stations, histSong->stationId);
+          PianoFindStationById(&app->ph, histSong->stationId);
 
       if (songStation == NULL) {
         BarUiMsg(&app->settings, MSG_ERR, "Station does not exist any more.\n");
@@ -622,11 +694,11 @@ BarUiActCallback(BarUiActBookmark) {
               BAR_RL_FULLRETURN, -1);
   if (selectBuf[0] == 's') {
     BarUiMsg(&app->settings, MSG_INFO, "Bookmarking song... ");
-    BarUiActDefaultPianoCall(PIANO_REQUEST_BOOKMARK_SONG, selSong);
+    BarUiActDefaultQueue(BAR_JOURNAL_BOOKMARK_SONG);
     BarUiActDefaultEventcmd("songbookmark");
   } else if (selectBuf[0] == 'a') {
     BarUiMsg(&app->settings, MSG_INFO, "Bookmarking artist... ");
-    BarUiActDefaultPianoCall(PIANO_REQUEST_BOOKMARK_ARTIST, selSong);
+    BarUiActDefaultQueue(BAR_JOURNAL_BOOKMARK_ARTIST);
     BarUiActDefaultEventcmd("artistbookmark");
   }
 }
@@ -635,21 +707,21 @@ BarUiActCallback(BarUiActBookmark) {
  */
 BarUiActCallback(BarUiActVolDown) {
   --app->settings.volume;
-  BarPlayerSetVolume(&app->player);
+  BarPlayerSetVolume(app->player);
 }
 
 /*	increase volume
  */
 BarUiActCallback(BarUiActVolUp) {
   ++app->settings.volume;
-  BarPlayerSetVolume(&app->player);
+  BarPlayerSetVolume(app->player);
 }
 
 /*	reset volume
  */
 BarUiActCallback(BarUiActVolReset) {
   app->settings.volume = 0;
-  BarPlayerSetVolume(&app->player);
+  BarPlayerSetVolume(app->player);
 }
 
 static const char *boolToYesNo(const bool value) {
@@ -867,3 +939,66 @@ BarUiActCallback(BarUiActManageStation) {
 
   PianoDestroyStationInfo(&reqData.info);
 }
+
+/*	print playback problems of this session, including the current song,
+ *	and how well rpc connections are reused
+ */
+BarUiActCallback(BarUiActStats) {
+  BarPlayerCounters_t total = app->counters;
+  /* the current song is added to the session when it is finished */
+  if (app->player->mode != PLAYER_DEAD) {
+    BarPlayerCountersAdd(&total, &app->player->counters);
+  }
+
+  BarUiMsg(&app->settings, MSG_NONE,
+           "songs:\t%u\n"
+           "underruns:\t%u\n"
+           "stalls:\t%u (%u ms)\n"
+           "decodeErrors:\t%u\n"
+           "retries:\t%u\n",
+           app->songsPlayed, BarSinksUnderruns(&app->sinks), total.stalls,
+           total.stallMs, total.decodeErrors, total.retries);
+  const unsigned int setups = total.filterBuilds + total.filterReuses;
+  BarUiMsg(&app->settings, MSG_NONE,
+           "filterGraphs:\t%u built, %u reused (%u us average setup)\n",
+           total.filterBuilds, total.filterReuses,
+           setups == 0 ? 0 : total.filterSetupUs / setups);
+
+  const BarRpc_t *const rpc = &app->rpc;
+  const unsigned int connects = rpc->stats.requests - rpc->stats.reused;
+  BarUiMsg(&app->settings, MSG_NONE,
+           "rpcRequests:\t%u (%u%% reused connections)\n"
+           "rpcHandshake:\t%llu ms average, %u ms last call\n",
+           rpc->stats.requests,
+           rpc->stats.requests == 0
+               ? 0
+               : rpc->stats.reused * 100 / rpc->stats.requests,
+           connects == 0 ? 0 : rpc->stats.handshakeUs / connects / 1000,
+           rpc->stats.lastHandshakeUs / 1000);
+  BarUiMsg(&app->settings, MSG_NONE, "searchCache:\t%u hits, %u misses\n",
+           app->searchCache.hits, app->searchCache.misses);
+  BarUiMsg(&app->settings, MSG_NONE,
+           "journal:\t%u pending, %u sent, %u retried, %u dropped\n",
+           BarJournalPending(&app->journal), app->journal.sent,
+           app->journal.retried, app->journal.dropped);
+
+  const BarStartup_t *const startup = &app->startup;
+  static const char *const phases[BAR_PHASE_COUNT] = {
+      [BAR_PHASE_INIT] = "init",         [BAR_PHASE_AUDIO] = "audio",
+      [BAR_PHASE_LOGIN] = "login",       [BAR_PHASE_STATIONS] = "stations",
+      [BAR_PHASE_SELECT] = "select",     [BAR_PHASE_PLAYLIST] = "playlist",
+      [BAR_PHASE_AUDIOWAIT] = "audioWait",
+  };
+  if (startup->firstSong == 0) {
+    return;
+  }
+  BarUiMsg(&app->settings, MSG_NONE, "startup:\t%u ms to first song\n",
+           startup->firstSong);
+  for (size_t i = 0; i < BAR_PHASE_COUNT; i++) {
+    if (startup->ended[i]) {
+      BarUiMsg(&app->settings, MSG_NONE, "  %s:\t%u ms (%u-%u)\n", phases[i],
+               startup->end[i] - startup->start[i], startup->start[i],
+               startup->end[i]);
+    }
+  }
+}
@@ -99,6 +99,7 @@ static const BarUiDispatchAction_t dispatchActions[BAR_KS_COUNT] = {
      "act_songpause"},
     {'^', BAR_DC_GLOBAL, BarUiActVolReset, "reset volume", "act_volreset"},
     {'!', BAR_DC_GLOBAL, BarUiActSettings, "change settings", "act_settings"},
+    {'#', BAR_DC_GLOBAL, BarUiActStats, "playback statistics", "act_stats"},
 };
 
 #include <piano.h>